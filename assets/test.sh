@@ -25,6 +25,33 @@ incorrect_inputs=(
     "--flipp-horizontal"
     "--fancyy"
     "-fancy"
+    "--color 256"
+    "--color 16"
+    "--cells ascii"
+    "--sampling bilinear"
+    "--dither random"
+    "--sampling shape --dither bayer4"
+    "--jobs 0"
+    "--width 0"
+    "--height -5"
+    "--aspect 0"
+    "--aspect nan"
+    "--blur 0"
+    "--blur 17"
+    "--blur nan"
+    "--blur"
+    "--sharpen 0"
+    "--sharpen 1:nan"
+    "--sharpen 1:x"
+    "--contrast -1"
+    "--gamma 0"
+    "--gamma nan"
+    "--levels 200:100"
+    "--levels 10"
+    "--threshold 300"
+    "--posterize 1"
+    "--posterize 2.5"
+    "--cells halfblock --color truecolor"
 )
 
 input_files=(
@@ -0,0 +1,406 @@
+/**
+ * @file Benchmark.cpp
+ * @brief Microbenchmarks of the stages of the pipeline (make bench)
+ *
+ * @details Every stage is run on the example images at several scales, the time of every run is measured and the
+ * allocations are counted by the replaced global operator new. The results are printed as a table or, with --json,
+ * written to a file so that two builds can be compared.
+ *
+ * Usage: ./benchmark [--runs N] [--json file]
+ */
+#include <SDL2/SDL_ttf.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+#include "GlyphAtlas.hpp"
+#include "ImageJPG.hpp"
+#include "ImagePNG.hpp"
+#include "OutputFile.hpp"
+#include "TextRasterizer.hpp"
+#include "Trace.hpp"
+#include "Transform.hpp"
+
+namespace
+{
+    std::atomic<size_t> allocation_count(0);
+    std::atomic<size_t> allocation_bytes(0);
+}
+
+// the default operator delete releases the memory with free
+void *operator new(size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+namespace
+{
+    const char *FONT_PATH = "assets/CourierPrime.ttf";
+    const char *OUTPUT_PATH = "bench_output.txt";
+    const int RENDER_FONT_SIZE = 4;
+
+    const std::vector<std::string> IMAGES = {
+        "examples/cat1.jpg", "examples/cat1.png", "examples/cat2.jpg", "examples/typek.jpg", "examples/vagner.jpg",
+        "examples2/ptak.jpg", "examples2/cats/cat.png", "examples2/cats/tiger1.jpg", "examples2/cats/tiger4.png",
+        "examples2/space/1.jpg", "examples2/space/4.png"};
+    const std::vector<double> SCALES = {1.0, 0.5, 0.1};
+
+    /**
+     * @brief Measured statistics of one stage on one image
+     */
+    struct Result
+    {
+        std::string stage;
+        std::string image;
+        double scale;
+        size_t runs;
+        double p50_ms;
+        double p99_ms;
+        double megapixels_per_s;
+        double bytes_per_s;
+        size_t allocations;
+        size_t allocated_bytes;
+        /**
+         * @brief Whether the stage must not allocate once the buffer pool is warm (--check-allocations)
+         */
+        bool allocation_free = false;
+    };
+
+    /**
+     * @brief Run the stage (once to warm up, then runs times) and collect the statistics
+     * @param name Name of the stage
+     * @param image Path to the image
+     * @param scale Scale of the image
+     * @param runs Number of measured runs
+     * @param prepare Called before every run, not measured
+     * @param stage The measured code
+     * @param pixels Number of pixels processed by one run
+     * @param bytes Number of bytes processed (read or written) by one run
+     */
+    Result measure(const std::string &name, const std::string &image, double scale, size_t runs,
+                   const std::function<void()> &prepare, const std::function<void()> &stage, size_t pixels, size_t bytes)
+    {
+        prepare();
+        stage();
+
+        std::vector<double> times;
+        size_t count = 0, allocated = 0;
+        for (size_t i = 0; i < runs; ++i)
+        {
+            prepare();
+            size_t count_before = allocation_count.load(), bytes_before = allocation_bytes.load();
+            auto start = std::chrono::steady_clock::now();
+            stage();
+            auto end = std::chrono::steady_clock::now();
+            count += allocation_count.load() - count_before;
+            allocated += allocation_bytes.load() - bytes_before;
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        std::sort(times.begin(), times.end());
+        auto percentile = [&](double p)
+        {
+            size_t rank = static_cast<size_t>(p * times.size() + 0.999999);
+            return times[std::min(std::max<size_t>(rank, 1), times.size()) - 1];
+        };
+        Result result{name, image, scale, runs, percentile(0.5), percentile(0.99), 0, 0, count / runs, allocated / runs};
+        double seconds = result.p50_ms / 1000.0;
+        if (seconds > 0)
+        {
+            result.megapixels_per_s = pixels / seconds / 1e6;
+            result.bytes_per_s = bytes / seconds;
+        }
+        return result;
+    }
+
+    bool isPng(const std::string &path)
+    {
+        std::unique_ptr<ImageSource> source = ImageSource::fromFile(path);
+        return source && source->format() == ImageSource::Format::PNG;
+    }
+
+    std::unique_ptr<Image> createImage(const std::string &path)
+    {
+        if (isPng(path))
+        {
+            return std::make_unique<ImagePNG>();
+        }
+        return std::make_unique<ImageJPG>();
+    }
+
+    size_t fileSize(const std::string &path)
+    {
+        struct stat info;
+        return stat(path.c_str(), &info) == 0 ? info.st_size : 0;
+    }
+
+    /**
+     * @brief Run all stages on the image at the scale
+     */
+    void benchImage(const std::string &path, double scale, size_t runs, GlyphAtlas *atlas, std::vector<Result> &results)
+    {
+        Img img;
+        img.image_path = path;
+        img.scale = scale;
+
+        // the file is mapped once, the stages measure the decoding and not the opening of the file
+        std::unique_ptr<ImageSource> source = ImageSource::fromFile(path);
+        std::unique_ptr<Image> image = createImage(path);
+        if (!source || !image->load(*source, false, 1.0))
+        {
+            std::cerr << "Skipping " << path << ", it can't be loaded." << std::endl;
+            return;
+        }
+        const size_t source_pixels = static_cast<size_t>(image->width) * image->height;
+        const std::string loader = isPng(path) ? "ImagePNG::load" : "ImageJPG::load";
+
+        // decoding, the jpeg decoder reduces the size in the IDCT for small scales
+        std::unique_ptr<Image> decoded;
+        results.push_back(measure(loader, path, scale, runs, [&]
+                                  { decoded = createImage(path); },
+                                  [&]
+                                  { decoded->load(*source, false, scale); },
+                                  source_pixels, fileSize(path)));
+        results.back().allocation_free = true;
+
+        // conversion of the decoded image, nearest and area sampled, rotated with flips (the former FilterRotate and FilterFlip)
+        const size_t decoded_pixels = static_cast<size_t>(decoded->width) * decoded->height;
+        decoded->imgToAscii(img);
+        const size_t ascii_bytes = decoded->ascii_image.size();
+        results.push_back(measure("Image::imgToAscii", path, scale, runs, [] {}, [&]
+                                  { decoded->imgToAscii(img); },
+                                  decoded_pixels, ascii_bytes));
+        results.back().allocation_free = true;
+
+        Img area = img;
+        area.sampling = Sampling::Area;
+        results.push_back(measure("Image::imgToAscii area", path, scale, runs, [] {}, [&]
+                                  { decoded->imgToAscii(area); },
+                                  decoded_pixels, ascii_bytes));
+        results.back().allocation_free = true;
+
+        // terminal cells twice as tall as wide, every other line is sampled (the default of the console output)
+        Img terminal = img;
+        terminal.cell_aspect = 0.5;
+        decoded->imgToAscii(terminal);
+        const size_t terminal_bytes = decoded->ascii_image.size();
+        results.push_back(measure("Image::imgToAscii aspect 0.5", path, scale, runs, [] {}, [&]
+                                  { decoded->imgToAscii(terminal); },
+                                  decoded_pixels, terminal_bytes));
+        results.back().allocation_free = true;
+
+        // every cell with contrast is matched against the masks of all glyphs of the charset
+        Img shape = img;
+        shape.sampling = Sampling::Shape;
+        results.push_back(measure("Image::imgToAscii shape", path, scale, runs, [] {}, [&]
+                                  { decoded->imgToAscii(shape); },
+                                  decoded_pixels, ascii_bytes));
+        results.back().allocation_free = true;
+
+        for (const auto &[name, mode] : {std::make_pair("Image::imgToAscii braille", CellMode::Braille),
+                                         std::make_pair("Image::imgToAscii halfblock", CellMode::HalfBlock)})
+        {
+            Img cells = img;
+            cells.cells = mode;
+            results.push_back(measure(name, path, scale, runs, [] {}, [&]
+                                      { decoded->imgToAscii(cells); },
+                                      decoded_pixels, ascii_bytes));
+            results.back().allocation_free = true;
+        }
+
+        // the ordered dithering keeps the rows independent, the error diffusion is serial
+        for (const auto &[name, dithering] : {std::make_pair("Image::imgToAscii bayer8", Dithering::Bayer8),
+                                              std::make_pair("Image::imgToAscii bluenoise", Dithering::BlueNoise),
+                                              std::make_pair("Image::imgToAscii diffusion", Dithering::Diffusion)})
+        {
+            Img dithered = img;
+            dithered.dither = dithering;
+            results.push_back(measure(name, path, scale, runs, [] {}, [&]
+                                      { decoded->imgToAscii(dithered); },
+                                      decoded_pixels, ascii_bytes));
+            results.back().allocation_free = true;
+        }
+
+        Img rotated = img;
+        rotated.rotate = 90;
+        rotated.flip_horizontal = true;
+        results.push_back(measure("Transform", path, scale, runs, [] {}, [&]
+                                  { Transform transform(decoded->width, decoded->height, rotated, scale / decoded->decoded_scale); },
+                                  decoded_pixels, 0));
+        results.back().allocation_free = true;
+        results.push_back(measure("Image::imgToAscii rotate+flip", path, scale, runs, [] {}, [&]
+                                  { decoded->imgToAscii(rotated); },
+                                  decoded_pixels, ascii_bytes));
+        results.back().allocation_free = true;
+
+        // five tone operations compose to one table fused with the glyphs, they should cost the same as none
+        Img toned = img;
+        toned.tone = {{ToneOp::Kind::Levels, 16, 240}, {ToneOp::Kind::Gamma, 1.8}, {ToneOp::Kind::Contrast, 1.2},
+                      {ToneOp::Kind::Posterize, 8}, {ToneOp::Kind::Negate}};
+        results.push_back(measure("Image::imgToAscii tone x5", path, scale, runs, [] {}, [&]
+                                  { decoded->imgToAscii(toned); },
+                                  decoded_pixels, ascii_bytes));
+        results.back().allocation_free = true;
+
+        // separable gaussian and unsharp mask before the conversion, on the calling thread
+        Img filtered = img;
+        filtered.filters = {{FilterOp::Kind::Blur, 0.6}, {FilterOp::Kind::Sharpen, 1, 1.5}};
+        results.push_back(measure("Image::imgToAscii blur+sharpen", path, scale, runs, [] {}, [&]
+                                  { decoded->imgToAscii(filtered); },
+                                  decoded_pixels, ascii_bytes));
+        results.back().allocation_free = true;
+
+        // decoding and conversion at once, row by row, into the same image (the ascii image keeps its size)
+        std::unique_ptr<Image> streamed = createImage(path);
+        results.push_back(measure("Image::loadAscii", path, scale, runs, [] {}, [&]
+                                  { streamed->loadAscii(*source, img); },
+                                  source_pixels, fileSize(path)));
+        results.back().allocation_free = true;
+
+        decoded->imgToAscii(img);
+        if (atlas)
+        {
+            TextRasterizer rasterizer(*atlas, *decoded, RENDER_FONT_SIZE);
+            std::vector<unsigned char> pixels(static_cast<size_t>(rasterizer.width()) * rasterizer.height());
+            results.push_back(measure("TextRasterizer::renderRows", path, scale, runs, [] {}, [&]
+                                      { rasterizer.renderRows(0, rasterizer.height(), pixels.data()); },
+                                      pixels.size(), pixels.size()));
+        }
+
+        std::vector<std::pair<std::unique_ptr<Image>, Img>> images;
+        images.emplace_back(std::move(decoded), img);
+        OutputFile output;
+        results.push_back(measure("OutputFile::output", path, scale, runs, [] {}, [&]
+                                  { output.output(images, OUTPUT_PATH); },
+                                  0, images.front().first->ascii_image.size() + 2));
+    }
+
+    void writeJson(const std::vector<Result> &results, std::ostream &out)
+    {
+        out << "[\n";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const Result &r = results[i];
+            out << "  {\"stage\": " << Trace::jsonString(r.stage) << ", \"image\": " << Trace::jsonString(r.image)
+                << ", \"scale\": " << r.scale << ", \"runs\": " << r.runs
+                << ", \"p50_ms\": " << r.p50_ms << ", \"p99_ms\": " << r.p99_ms
+                << ", \"megapixels_per_s\": " << r.megapixels_per_s << ", \"bytes_per_s\": " << r.bytes_per_s
+                << ", \"allocations\": " << r.allocations << ", \"allocated_bytes\": " << r.allocated_bytes << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "]\n";
+    }
+
+    void writeTable(const std::vector<Result> &results, std::ostream &out)
+    {
+        out << std::left << std::setw(32) << "stage" << std::setw(28) << "image" << std::right << std::setw(6) << "scale"
+            << std::setw(10) << "p50 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "MP/s" << std::setw(10) << "MB/s"
+            << std::setw(8) << "allocs" << std::setw(12) << "alloc KB" << "\n";
+        out << std::fixed;
+        for (const Result &r : results)
+        {
+            out << std::left << std::setw(32) << r.stage << std::setw(28) << r.image << std::right
+                << std::setprecision(2) << std::setw(6) << r.scale << std::setprecision(3) << std::setw(10) << r.p50_ms
+                << std::setw(10) << r.p99_ms << std::setprecision(1) << std::setw(10) << r.megapixels_per_s
+                << std::setw(10) << r.bytes_per_s / 1e6 << std::setw(8) << r.allocations
+                << std::setw(12) << r.allocated_bytes / 1024 << "\n";
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t runs = 10;
+    std::string json_path;
+    bool check_allocations = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc)
+        {
+            runs = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--json" && i + 1 < argc)
+        {
+            json_path = argv[++i];
+        }
+        else if (arg == "--check-allocations")
+        {
+            check_allocations = true;
+        }
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--runs N] [--json file] [--check-allocations]" << std::endl;
+            return 1;
+        }
+    }
+
+    GlyphAtlas *atlas = nullptr;
+    if (TTF_Init() == 0)
+    {
+        atlas = GlyphAtlas::get(FONT_PATH, RENDER_FONT_SIZE);
+    }
+    if (!atlas)
+    {
+        std::cerr << "Font " << FONT_PATH << " can't be opened, rendering is not measured." << std::endl;
+    }
+
+    std::vector<Result> results;
+    for (const std::string &path : IMAGES)
+    {
+        for (double scale : SCALES)
+        {
+            benchImage(path, scale, runs, atlas, results);
+        }
+    }
+    std::remove(OUTPUT_PATH);
+    GlyphAtlas::clear();
+    TTF_Quit();
+
+    writeTable(results, std::cout);
+    if (!json_path.empty())
+    {
+        std::ofstream json(json_path);
+        if (!json.is_open())
+        {
+            std::cout << "Can't write " << json_path << std::endl;
+            return 1;
+        }
+        writeJson(results, json);
+    }
+
+    if (check_allocations)
+    { // decoding and conversion draw all their buffers from the pool once it is warm
+        bool allocation_free = true;
+        for (const Result &r : results)
+        {
+            if (r.allocation_free && r.allocations > 0)
+            {
+                std::cout << r.stage << " on " << r.image << " at " << r.scale << " allocates " << r.allocations << " times per run." << std::endl;
+                allocation_free = false;
+            }
+        }
+        if (!allocation_free)
+        {
+            return 1;
+        }
+        std::cout << "No allocations in the steady state." << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "AnsiText.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "Utf8.hpp"
+
+namespace
+{
+    /**
+     * @brief Levels of the 6x6x6 colour cube of the xterm palette (indices 16 - 231)
+     */
+    const int CUBE_LEVELS[6] = {0, 95, 135, 175, 215, 255};
+
+    /**
+     * @brief Bits per channel of the precomputed palette lookup
+     */
+    const int LUT_BITS = 5;
+
+    int distance(int r1, int g1, int b1, int r2, int g2, int b2)
+    {
+        return (r1 - r2) * (r1 - r2) + (g1 - g2) * (g1 - g2) + (b1 - b2) * (b1 - b2);
+    }
+
+    int nearestLevel(int value)
+    {
+        int nearest = 0;
+        for (int i = 1; i < 6; ++i)
+        {
+            if (std::abs(CUBE_LEVELS[i] - value) < std::abs(CUBE_LEVELS[nearest] - value))
+            {
+                nearest = i;
+            }
+        }
+        return nearest;
+    }
+
+    /**
+     * @brief Nearest palette colour of every colour quantised to LUT_BITS per channel, either from the colour cube or
+     * from the gray ramp (indices 232 - 255, 8 + 10 * i)
+     */
+    std::array<unsigned char, 1 << (3 * LUT_BITS)> buildPalette()
+    {
+        std::array<unsigned char, 1 << (3 * LUT_BITS)> palette;
+        const int half = 1 << (7 - LUT_BITS);
+        for (int i = 0; i < static_cast<int>(palette.size()); ++i)
+        {
+            // the centre of the quantised colour
+            int r = ((i >> (2 * LUT_BITS)) << (8 - LUT_BITS)) + half;
+            int g = (((i >> LUT_BITS) & ((1 << LUT_BITS) - 1)) << (8 - LUT_BITS)) + half;
+            int b = ((i & ((1 << LUT_BITS) - 1)) << (8 - LUT_BITS)) + half;
+
+            int cr = nearestLevel(r), cg = nearestLevel(g), cb = nearestLevel(b);
+            int cube = distance(r, g, b, CUBE_LEVELS[cr], CUBE_LEVELS[cg], CUBE_LEVELS[cb]);
+
+            int step = std::min(std::max(((r + g + b) / 3 - 3) / 10, 0), 23);
+            int gray = 8 + 10 * step;
+            if (distance(r, g, b, gray, gray, gray) < cube)
+            {
+                palette[i] = 232 + step;
+            }
+            else
+            {
+                palette[i] = 16 + 36 * cr + 6 * cg + cb;
+            }
+        }
+        return palette;
+    }
+
+    /**
+     * @brief The empty braille pattern U+2800 in UTF-8
+     */
+    const char BLANK_BRAILLE[3] = {'\xE2', '\xA0', '\x80'};
+
+    void appendNumber(std::string &text, unsigned int value)
+    {
+        char digits[3];
+        int count = 0;
+        do
+        {
+            digits[count++] = '0' + value % 10;
+            value /= 10;
+        } while (value > 0);
+        while (count > 0)
+        {
+            text += digits[--count];
+        }
+    }
+}
+
+std::string AnsiText::render(const Image &image, ColorMode mode)
+{
+    const size_t cells = static_cast<size_t>(image.ascii_width) * image.ascii_height;
+    const Image::ColorPlanes &colors = image.ascii_colors, &backgrounds = image.ascii_backgrounds;
+    if (mode == ColorMode::None || colors.red.size() < cells || colors.green.size() < cells || colors.blue.size() < cells)
+    {
+        return image.ascii_image;
+    }
+    const bool has_backgrounds = backgrounds.red.size() >= cells && backgrounds.green.size() >= cells && backgrounds.blue.size() >= cells;
+
+    // appends the escape of the colour (38 foreground, 48 background) if it differs from the previous one
+    auto appendColor = [mode](std::string &text, const char *layer, unsigned char r, unsigned char g, unsigned char b, int64_t &previous)
+    {
+        int64_t current = mode == ColorMode::TrueColor ? (r << 16 | g << 8 | b) : paletteIndex(r, g, b);
+        if (current == previous)
+        {
+            return;
+        }
+        text += "\x1b[";
+        text += layer;
+        if (mode == ColorMode::TrueColor)
+        {
+            text += ";2;";
+            appendNumber(text, r);
+            text += ';';
+            appendNumber(text, g);
+            text += ';';
+            appendNumber(text, b);
+        }
+        else
+        {
+            text += ";5;";
+            appendNumber(text, current);
+        }
+        text += 'm';
+        previous = current;
+    };
+
+    std::string text;
+    text.reserve(image.ascii_image.size() * 2);
+    int64_t previous = -1, previous_background = -1;
+    size_t cell = 0, position = 0;
+    for (unsigned int y = 0; y < image.ascii_height; ++y)
+    {
+        for (unsigned int x = 0; x < image.ascii_width; ++x, ++cell)
+        {
+            // the cells of the braille and half block modes take several bytes
+            const char *glyph = &image.ascii_image[position];
+            const size_t length = Utf8::length(*glyph);
+            position += length;
+            if (has_backgrounds)
+            {
+                appendColor(text, "48", backgrounds.red[cell], backgrounds.green[cell], backgrounds.blue[cell], previous_background);
+            }
+            // blank cells (a space, an empty braille pattern) show no colour, they keep the previous one
+            const bool blank = length == 1 ? *glyph == ' ' : length == 3 && std::memcmp(glyph, BLANK_BRAILLE, 3) == 0;
+            if (!blank)
+            {
+                appendColor(text, "38", colors.red[cell], colors.green[cell], colors.blue[cell], previous);
+            }
+            text.append(glyph, length);
+        }
+        if (previous_background >= 0)
+        { // the background would fill the rest of the line
+            text += "\x1b[49m";
+            previous_background = -1;
+        }
+        text += image.ascii_image[position++]; // line end
+    }
+    text += "\x1b[0m";
+    return text;
+}
+
+unsigned char AnsiText::paletteIndex(unsigned char red, unsigned char green, unsigned char blue)
+{
+    static const std::array<unsigned char, 1 << (3 * LUT_BITS)> palette = buildPalette();
+    const int shift = 8 - LUT_BITS;
+    return palette[(red >> shift) << (2 * LUT_BITS) | (green >> shift) << LUT_BITS | (blue >> shift)];
+}
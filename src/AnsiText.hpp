@@ -0,0 +1,35 @@
+#ifndef ASCII_ART_ANSITEXT_HPP
+#define ASCII_ART_ANSITEXT_HPP
+
+#include <string>
+#include "Image.hpp"
+#include "ImgOptions.hpp"
+
+/**
+ * @brief Renders the ascii image with ANSI colour escapes for the terminal
+ *
+ * @details Every cell gets the foreground colour of its pixels, either 24-bit or the nearest colour of the xterm
+ * 256-colour palette (looked up in a colour cube precomputed for 5 bits per channel). An escape is written only when
+ * the colour changes: consecutive cells quantised to the same colour share one escape and blank cells keep the previous
+ * one, so flat areas cost no more than the plain text. The half block cells also get the background colour of their
+ * lower halves, it is reset at the end of every line.
+ */
+class AnsiText
+{
+public:
+    /**
+     * @brief Render the ascii image with the colours of its cells
+     * @param image The image with the converted ascii image and the colours of the cells (ascii_colors, ascii_backgrounds)
+     * @param mode Colours of the escapes, the plain ascii image is returned for ColorMode::None or without colours
+     * @return std::string the text with the escapes, the colour is reset at the end
+     */
+    static std::string render(const Image &image, ColorMode mode);
+
+private:
+    /**
+     * @brief Get the index of the xterm palette colour nearest to the colour
+     */
+    static unsigned char paletteIndex(unsigned char red, unsigned char green, unsigned char blue);
+};
+
+#endif // ASCII_ART_ANSITEXT_HPP
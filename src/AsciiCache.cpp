@@ -0,0 +1,287 @@
+#include "AsciiCache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace
+{
+    /**
+     * @brief Bump when the format of the entries or the conversion changes, old entries are ignored then
+     */
+    const char *CACHE_MAGIC = "ASCII-ART-CACHE 5";
+    const char *ENTRY_EXTENSION = ".ascii";
+
+    /**
+     * @brief Temporary files older than this were left by a crashed or killed writer, no writer takes so long
+     */
+    const std::chrono::minutes TEMPORARY_MAX_AGE(10);
+
+    /**
+     * @brief 64-bit hash processing 8 bytes at a time (multiply and xor-shift mixing)
+     */
+    class Hasher
+    {
+    public:
+        void add(const void *bytes, size_t size)
+        {
+            const unsigned char *p = static_cast<const unsigned char *>(bytes);
+            for (; size >= 8; p += 8, size -= 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, p, 8);
+                mix(word);
+            }
+            uint64_t tail = 0;
+            std::memcpy(&tail, p, size);
+            mix(tail ^ (static_cast<uint64_t>(size) << 56));
+        }
+
+        template <typename T>
+        void addValue(const T &value)
+        {
+            add(&value, sizeof(value));
+        }
+
+        std::string hex() const
+        {
+            char buffer[17];
+            std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(finish(hash)));
+            return buffer;
+        }
+
+    private:
+        void mix(uint64_t word)
+        {
+            hash = (hash ^ finish(word)) * 0x9E3779B97F4A7C15ull;
+        }
+
+        static uint64_t finish(uint64_t x)
+        {
+            x ^= x >> 33;
+            x *= 0xFF51AFD7ED558CCDull;
+            x ^= x >> 33;
+            x *= 0xC4CEB9FE1A85EC53ull;
+            x ^= x >> 33;
+            return x;
+        }
+
+        uint64_t hash = 0xCBF29CE484222325ull;
+    };
+}
+
+AsciiCache::AsciiCache(const std::string &directory, uintmax_t max_size) : directory(directory), max_size(max_size)
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+}
+
+std::string AsciiCache::key(const ImageSource &source, const Img &img) const
+{
+    Hasher hasher;
+    hasher.add(CACHE_MAGIC, std::strlen(CACHE_MAGIC));
+    hasher.add(source.data(), source.size());
+    // the variable-length parts are preceded by their length (and the lists by a tag), so no two option sets hash the same bytes
+    hasher.addValue(img.charset->size());
+    hasher.add(img.charset->data(), img.charset->size());
+    hasher.addValue(img.brightness);
+    hasher.addValue(img.scale);
+    hasher.addValue(img.columns);
+    hasher.addValue(img.lines);
+    hasher.addValue(img.cell_aspect);
+    hasher.addValue(img.invert);
+    hasher.addValue(img.rotate);
+    hasher.addValue(img.flip_horizontal);
+    hasher.addValue(img.flip_vertical);
+    hasher.addValue(img.sampling);
+    hasher.addValue(img.cells);
+    hasher.addValue(img.dither);
+    hasher.addValue(img.color);
+    hasher.addValue('T');
+    hasher.addValue(img.tone.size());
+    for (const ToneOp &operation : img.tone)
+    {
+        hasher.addValue(operation.kind);
+        hasher.addValue(operation.first);
+        hasher.addValue(operation.second);
+    }
+    hasher.addValue('F');
+    hasher.addValue(img.filters.size());
+    for (const FilterOp &filter : img.filters)
+    {
+        hasher.addValue(filter.kind);
+        hasher.addValue(filter.sigma);
+        hasher.addValue(filter.amount);
+        hasher.addValue(filter.tone_before);
+    }
+    return hasher.hex();
+}
+
+bool AsciiCache::load(const std::string &key, Image &image) const
+{
+    std::string path = entryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    std::string magic;
+    unsigned int width, height, ascii_width, ascii_height, colors;
+    size_t size;
+    if (!std::getline(file, magic) || magic != CACHE_MAGIC || !(file >> width >> height >> ascii_width >> ascii_height >> size >> colors) ||
+        file.get() != '\n' || colors > 2 || size > 4 * (static_cast<size_t>(ascii_width) + 1) * ascii_height)
+    {
+        return false;
+    }
+
+    // the text is UTF-8 for the braille and half block cells, its size is stored
+    std::string ascii_image(size, '\0');
+    if (size > 0 && !file.read(&ascii_image[0], size))
+    {
+        return false;
+    }
+    // the colour planes of the cells follow the text, then the background planes of the half blocks
+    Image::ColorPlanes ascii_colors, ascii_backgrounds;
+    std::vector<unsigned char> *planes[] = {&ascii_colors.red, &ascii_colors.green, &ascii_colors.blue,
+                                            &ascii_backgrounds.red, &ascii_backgrounds.green, &ascii_backgrounds.blue};
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        planes[i]->resize(i / 3 < colors ? static_cast<size_t>(ascii_width) * ascii_height : 0);
+        if (!file.read(reinterpret_cast<char *>(planes[i]->data()), planes[i]->size()))
+        {
+            return false;
+        }
+    }
+    if (file.peek() != EOF)
+    {
+        return false;
+    }
+
+    image.width = width;
+    image.height = height;
+    image.ascii_width = ascii_width;
+    image.ascii_height = ascii_height;
+    image.ascii_image = std::move(ascii_image);
+    image.ascii_colors = std::move(ascii_colors);
+    image.ascii_backgrounds = std::move(ascii_backgrounds);
+
+    // the entry was used, it is the last one to be evicted
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+
+bool AsciiCache::store(const std::string &key, const Image &image) const
+{
+    // unique per process and thread, the complete file is renamed to the entry at once
+    std::ostringstream temporary;
+    temporary << entryPath(key) << ".tmp" << getpid() << "-" << std::hash<std::thread::id>()(std::this_thread::get_id());
+    std::string temporary_path = temporary.str();
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary);
+        if (!file.is_open())
+        {
+            return false;
+        }
+        const int colors = image.ascii_colors.red.empty() ? 0 : image.ascii_backgrounds.red.empty() ? 1 : 2;
+        file << CACHE_MAGIC << "\n"
+             << image.width << " " << image.height << " " << image.ascii_width << " " << image.ascii_height << " "
+             << image.ascii_image.size() << " " << colors << "\n";
+        file.write(image.ascii_image.data(), image.ascii_image.size());
+        for (const std::vector<unsigned char> *plane : {&image.ascii_colors.red, &image.ascii_colors.green, &image.ascii_colors.blue,
+                                                        &image.ascii_backgrounds.red, &image.ascii_backgrounds.green, &image.ascii_backgrounds.blue})
+        {
+            file.write(reinterpret_cast<const char *>(plane->data()), plane->size());
+        }
+        if (!file.good())
+        {
+            file.close();
+            std::remove(temporary_path.c_str());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_path, entryPath(key), error);
+    if (error)
+    {
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void AsciiCache::evict() const
+{
+    struct Entry
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type used;
+        uintmax_t size;
+    };
+
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code error;
+    const auto now = std::filesystem::file_time_type::clock::now();
+    const std::string temporary_marker = std::string(ENTRY_EXTENSION) + ".tmp";
+    for (const auto &file : std::filesystem::directory_iterator(directory, error))
+    {
+        const bool temporary = file.path().filename().string().find(temporary_marker) != std::string::npos;
+        if (!temporary && file.path().extension() != ENTRY_EXTENSION)
+        {
+            continue;
+        }
+        std::error_code entry_error;
+        uintmax_t size = file.file_size(entry_error);
+        auto used = file.last_write_time(entry_error);
+        if (entry_error)
+        { // removed by another process meanwhile
+            continue;
+        }
+        if (temporary)
+        { // a file being written counts to the size, an abandoned one is removed
+            if (now - used > TEMPORARY_MAX_AGE)
+            {
+                std::filesystem::remove(file.path(), entry_error);
+            }
+            else
+            {
+                total += size;
+            }
+            continue;
+        }
+        entries.push_back({file.path(), used, size});
+        total += size;
+    }
+    if (total <= max_size)
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+              { return a.used < b.used; });
+    for (const Entry &entry : entries)
+    {
+        if (total <= max_size)
+        {
+            break;
+        }
+        std::filesystem::remove(entry.path, error);
+        total -= entry.size;
+    }
+}
+
+std::string AsciiCache::entryPath(const std::string &key) const
+{
+    return (std::filesystem::path(directory) / (key + ENTRY_EXTENSION)).string();
+}
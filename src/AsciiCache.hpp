@@ -0,0 +1,73 @@
+#ifndef ASCII_ART_ASCIICACHE_HPP
+#define ASCII_ART_ASCIICACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include "Image.hpp"
+#include "ImageSource.hpp"
+#include "ImgOptions.hpp"
+
+/**
+ * @brief Persistent on-disk cache of the converted ascii images
+ *
+ * @details An entry is addressed by a hash of the bytes of the image file and of every option changing the result
+ * (charset, brightness, scale, invert, rotate, flips, sampling, cells, dither, colour, tone, filters), so a changed file or option never hits a stale entry.
+ * On a hit the image is neither decoded nor converted, the ascii image (and the colours of its cells) is read from the cache file.
+ *
+ * Entries are written to a temporary file and renamed, so concurrent processes sharing the directory never see
+ * a partial entry. Every hit refreshes the modification time of the entry and evict() removes the least recently
+ * used entries above the size limit. Temporary files count to the size too, the ones left by crashed writers are removed.
+ */
+class AsciiCache
+{
+public:
+    /**
+     * @brief Default limit of the size of all entries in bytes
+     */
+    static const uintmax_t DEFAULT_MAX_SIZE = 512ull * 1024 * 1024;
+
+    /**
+     * @brief Construct a new AsciiCache, the directory is created if it does not exist
+     * @param directory Path to the cache directory
+     * @param max_size Limit of the size of all entries in bytes
+     */
+    explicit AsciiCache(const std::string &directory, uintmax_t max_size = DEFAULT_MAX_SIZE);
+
+    /**
+     * @brief Compute the key of the image with its options
+     * @param source The bytes of the encoded image
+     * @param img Configuration of the image (options)
+     * @return std::string the key
+     */
+    std::string key(const ImageSource &source, const Img &img) const;
+
+    /**
+     * @brief Fill the ascii image (and the dimensions) of the image from the cache
+     * @param key Key of the entry
+     * @param image The image to fill
+     * @return true if the entry was found and is valid
+     */
+    bool load(const std::string &key, Image &image) const;
+
+    /**
+     * @brief Store the converted ascii image of the image
+     * @param key Key of the entry
+     * @param image The image with the converted ascii image
+     * @return true if the entry was written
+     */
+    bool store(const std::string &key, const Image &image) const;
+
+    /**
+     * @brief Remove the temporary files abandoned by crashed writers and the least recently used entries
+     * until the entries fit into the size limit
+     */
+    void evict() const;
+
+private:
+    std::string entryPath(const std::string &key) const;
+
+    std::string directory;
+    uintmax_t max_size;
+};
+
+#endif // ASCII_ART_ASCIICACHE_HPP
@@ -0,0 +1,594 @@
+#include "AsciiConverter.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include "BufferPool.hpp"
+#include "DitherMatrix.hpp"
+
+namespace
+{
+    /**
+     * @brief Smallest difference of the brightest and the darkest block of a cell which makes a shape,
+     * flatter cells get the glyph of their mean
+     */
+    const float MIN_CONTRAST = 32;
+
+    /**
+     * @brief Bits of the braille dots of the sample rows of a cell (dots 1 - 3 and 7 are in the left column, 4 - 6 and 8 in the right one)
+     */
+    const unsigned int BRAILLE_ROWS[4] = {0x09, 0x12, 0x24, 0xC0};
+    const unsigned int BRAILLE_LEFT = 0x47;
+
+    /**
+     * @brief Half blocks of the upper (bit 0) and the lower (bit 1) sample in UTF-8, padded to be copied four bytes at once
+     */
+    const char HALF_BLOCKS[4][4] = {{' '}, {'\xE2', '\x96', '\x80'}, {'\xE2', '\x96', '\x84'}, {'\xE2', '\x96', '\x88'}};
+    const size_t HALF_BLOCK_LENGTHS[4] = {1, 3, 3, 3};
+
+    /**
+     * @brief Quantise the samples (columns * lines of them, row by row) to the steps 0 ... top and pass the steps to emit in the same order
+     * @param steps Level of every gray in 1/256 of a step, at most top * 256
+     */
+    template <typename Emit>
+    void quantise(const unsigned char *values, size_t columns, size_t lines, const std::array<uint32_t, 256> &steps, uint32_t top, Dithering dithering, Emit emit)
+    {
+        if (dithering == Dithering::Diffusion)
+        {
+            // errors of the current row and of the row below, padded by one sample on both sides
+            PooledBuffer<int32_t> errors(2 * (columns + 2));
+            std::fill(errors.data(), errors.data() + 2 * (columns + 2), 0);
+            int32_t *current = errors.data() + 1, *below = current + columns + 2;
+            for (size_t y = 0; y < lines; ++y, values += columns)
+            {
+                for (size_t x = 0; x < columns; ++x)
+                {
+                    const int32_t level = static_cast<int32_t>(steps[values[x]]) + current[x];
+                    const uint32_t step = level < 0 ? 0 : std::min<uint32_t>((level + 128) / 256, top);
+                    const int32_t error = level - static_cast<int32_t>(step * 256);
+                    current[x + 1] += error * 7 / 16;
+                    below[x - 1] += error * 3 / 16;
+                    below[x] += error * 5 / 16;
+                    below[x + 1] += error / 16;
+                    emit(step);
+                }
+                std::swap(current, below);
+                std::fill(below - 1, below + columns + 1, 0);
+            }
+            return;
+        }
+        if (dithering == Dithering::None)
+        {
+            for (size_t i = 0; i < columns * lines; ++i)
+            {
+                emit(steps[values[i]] >> 8);
+            }
+            return;
+        }
+        // ordered, the threshold offset depends only on the position, the level never reaches top + 1
+        const DitherMatrix &matrix = DitherMatrix::get(dithering);
+        const size_t mask = matrix.mask();
+        for (size_t y = 0; y < lines; ++y, values += columns)
+        {
+            const unsigned char *thresholds = matrix.row(y);
+            for (size_t x = 0; x < columns; ++x)
+            {
+                emit((steps[values[x]] + thresholds[x & mask]) >> 8);
+            }
+        }
+    }
+
+#if defined(__GNUC__) && defined(__x86_64__) && defined(__linux__)
+// the popcount instruction is not in the baseline x86-64, the clone using it is picked when the program starts
+#define POPCOUNT_CLONES __attribute__((target_clones("popcnt", "default")))
+#else
+#define POPCOUNT_CLONES
+#endif
+
+    /**
+     * @brief Find the glyph with the nearest mask, the distance is the Hamming distance and then the difference of the brightness
+     * @param shape Mask of the cell
+     * @param mean Mean gray level of the cell
+     * @param masks Masks of the glyphs
+     * @param levels Gray levels of the glyphs
+     * @param count Number of the glyphs
+     * @return size_t index of the glyph
+     */
+    POPCOUNT_CLONES size_t nearestGlyph(uint64_t shape, int mean, const uint64_t *masks, const int *levels, size_t count)
+    {
+        size_t best = 0;
+        int best_score = -1;
+        for (size_t k = 0; k < count; ++k)
+        {
+            // the brightness only breaks the ties, its difference is always below 2048
+            int score = GlyphMasks::popcount(shape ^ masks[k]) * 2048 + std::abs(levels[k] - mean);
+            if (best_score < 0 || score < best_score)
+            {
+                best = k;
+                best_score = score;
+            }
+        }
+        return best;
+    }
+}
+
+AsciiConverter::AsciiConverter(const Transform &transform, const std::string &charset, double brightness, std::string &ascii_image, const ToneCurve *tone,
+                               CellMode cells)
+    : transform(transform), charset(charset), tone(tone && !tone->identity() ? tone : nullptr), glyphs(GlyphTable::get(charset, brightness)), table(glyphs.get()),
+      cells(cells), brightness(std::max(brightness, 0.0)), ascii_image(ascii_image), next_line(0)
+{
+    if (this->tone)
+    {
+        fused.emplace(*glyphs, *this->tone);
+        table = &*fused;
+    }
+    // a glyph of the charset is a single byte, the braille patterns and the half blocks take three
+    const size_t cell_bytes = cells == CellMode::Charset ? 1 : 3;
+    ascii_image.resize(static_cast<size_t>(lines()) * (columns() * cell_bytes + 1));
+    out = &ascii_image[0];
+}
+
+void AsciiConverter::convertImage(const unsigned char *data)
+{
+    // Rotated image is read across the rows of the source, going through the output in tiles keeps the source rows in cache
+    const size_t TILE = 64;
+    const std::vector<size_t> &lines = transform.lineOffsets();
+    const std::vector<size_t> &columns = transform.columnOffsets();
+    const size_t line_length = columns.size() + 1;
+
+    for (size_t tile_y = 0; tile_y < lines.size(); tile_y += TILE)
+    {
+        size_t end_y = std::min(tile_y + TILE, lines.size());
+        for (size_t tile_x = 0; tile_x < columns.size(); tile_x += TILE)
+        {
+            size_t end_x = std::min(tile_x + TILE, columns.size());
+            for (size_t y = tile_y; y < end_y; ++y)
+            {
+                const unsigned char *row = data + lines[y];
+                char *line = out + y * line_length;
+                for (size_t x = tile_x; x < end_x; ++x)
+                {
+                    line[x] = (*table)[row[columns[x]]];
+                }
+            }
+        }
+        for (size_t y = tile_y; y < end_y; ++y)
+        {
+            out[y * line_length + columns.size()] = '\n';
+        }
+    }
+    out += lines.size() * line_length;
+    next_line = lines.size();
+}
+
+void AsciiConverter::convertImageArea(const unsigned char *data, unsigned int height)
+{
+    const size_t columns = transform.columns(), lines = transform.lines();
+    PooledBuffer<unsigned char> means(columns * lines);
+    // the tone curve is applied to the pixels, not to their means
+    averageCells(data, height, means.data(), tone);
+
+    const unsigned char *mean = means.data();
+    for (size_t y = 0; y < lines; ++y)
+    {
+        for (size_t x = 0; x < columns; ++x)
+        {
+            *out++ = (*glyphs)[*mean++];
+        }
+        *out++ = '\n';
+    }
+    next_line = lines;
+}
+
+void AsciiConverter::convertImageShapes(const unsigned char *data, unsigned int height, const GlyphMasks &masks)
+{
+    // cells of single pixels have no shape, they get the glyphs of their pixels
+    const std::vector<Transform::Span> &lines = transform.lineSpans();
+    const std::vector<Transform::Span> &columns = transform.columnSpans();
+    auto single = [](const Transform::Span &span)
+    {
+        return span.last - span.first == 1;
+    };
+    if (std::all_of(lines.begin(), lines.end(), single) && std::all_of(columns.begin(), columns.end(), single))
+    {
+        convertImage(data);
+        return;
+    }
+
+    const int SIZE = GlyphMasks::MASK_SIZE;
+    const size_t stride = transform.width() + 1;
+    PooledBuffer<uint64_t> sums(stride * (height + 1));
+    // the tone curve is applied to the pixels, not to the blocks
+    summedArea(data, height, tone, sums.data());
+
+    // the blocks of the cells are in the orientation of the source, so the glyphs are rotated and flipped instead
+    const bool swap = transform.swapsAxes();
+    const size_t count = masks.size();
+    std::array<uint64_t, 256> oriented;
+    for (size_t k = 0; k < count; ++k)
+    {
+        oriented[k] = 0;
+        for (int row = 0; row < SIZE; ++row)
+        {
+            for (int column = 0; column < SIZE; ++column)
+            {
+                int x = transform.columnsMirrored() ? SIZE - 1 - column : column;
+                int y = transform.linesMirrored() ? SIZE - 1 - row : row;
+                if (masks.mask(k) >> GlyphMasks::bit(row, column) & 1)
+                {
+                    oriented[k] |= uint64_t(1) << (swap ? GlyphMasks::bit(x, y) : GlyphMasks::bit(y, x));
+                }
+            }
+        }
+    }
+    // mean gray level the brightness gives every glyph, glyphs it never gives are the last resort
+    std::array<int, 256> index, levels, hits{};
+    index.fill(-1);
+    levels.fill(0);
+    for (size_t k = 0; k < count; ++k)
+    {
+        index[static_cast<unsigned char>(masks.glyph(k))] = k;
+    }
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        int k = index[static_cast<unsigned char>((*glyphs)[gray])];
+        if (k >= 0)
+        {
+            levels[k] += gray;
+            hits[k]++;
+        }
+    }
+    for (size_t k = 0; k < count; ++k)
+    {
+        levels[k] = hits[k] > 0 ? levels[k] / hits[k] : 1024;
+    }
+
+    PooledBuffer<Blocks> line_blocks(lines.size()), column_blocks(columns.size());
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        line_blocks[i] = divide(lines[i], transform.linesMirrored());
+    }
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        column_blocks[i] = divide(columns[i], transform.columnsMirrored());
+    }
+
+    uint64_t grid[SIZE + 1][SIZE + 1];
+    float blocks[SIZE][SIZE];
+    for (size_t y = 0; y < lines.size(); ++y)
+    {
+        for (size_t x = 0; x < columns.size(); ++x)
+        {
+            const Transform::Span &xs = swap ? lines[y] : columns[x];
+            const Transform::Span &ys = swap ? columns[x] : lines[y];
+            uint64_t sum = sums[ys.last * stride + xs.last] - sums[ys.first * stride + xs.last]
+                         - sums[ys.last * stride + xs.first] + sums[ys.first * stride + xs.first];
+            uint64_t area = static_cast<uint64_t>(xs.last - xs.first) * (ys.last - ys.first);
+            const int mean = (sum + area / 2) / area;
+            if (area == 1)
+            {
+                *out++ = (*glyphs)[mean];
+                continue;
+            }
+
+            // sums at the corners of the blocks, every block is then four lookups to the grid
+            const Blocks &xb = swap ? line_blocks[y] : column_blocks[x];
+            const Blocks &yb = swap ? column_blocks[x] : line_blocks[y];
+            for (unsigned int i = 0; i < yb.count; ++i)
+            {
+                const uint64_t *row = &sums[yb.points[i] * stride];
+                for (unsigned int j = 0; j < xb.count; ++j)
+                {
+                    grid[i][j] = row[xb.points[j]];
+                }
+            }
+            float darkest = 255, brightest = 0;
+            for (unsigned int i = 0; i + 1 < yb.count; ++i)
+            {
+                for (unsigned int j = 0; j + 1 < xb.count; ++j)
+                {
+                    float block = (grid[i + 1][j + 1] - grid[i][j + 1] - grid[i + 1][j] + grid[i][j]) * yb.inverse[i] * xb.inverse[j];
+                    blocks[i][j] = block;
+                    darkest = std::min(darkest, block);
+                    brightest = std::max(brightest, block);
+                }
+            }
+            if (brightest - darkest < MIN_CONTRAST)
+            {
+                *out++ = (*glyphs)[mean];
+                continue;
+            }
+
+            const float middle = (darkest + brightest) / 2;
+            uint64_t shape = 0;
+            for (unsigned int i = 0; i + 1 < yb.count; ++i)
+            {
+                for (unsigned int j = 0; j + 1 < xb.count; ++j)
+                {
+                    if (blocks[i][j] > middle)
+                    {
+                        shape |= yb.rows[i] & xb.columns[j];
+                    }
+                }
+            }
+            *out++ = masks.glyph(nearestGlyph(shape, mean, oriented.data(), levels.data(), count));
+        }
+        *out++ = '\n';
+    }
+    next_line = lines.size();
+}
+
+void AsciiConverter::convertImageDithered(const unsigned char *data, unsigned int height, bool area, Dithering dithering)
+{
+    const size_t sample_columns = transform.columns(), sample_lines = transform.lines();
+    PooledBuffer<unsigned char> values(sample_columns * sample_lines);
+    samples(data, height, area, tone, values.data());
+
+    // the same levels as the glyph table has, the glyph of the level is the step it is quantised to
+    const uint32_t top = charset.empty() ? 0 : charset.size() - 1;
+    const char *charset_glyphs = charset.empty() ? " " : charset.data();
+    std::array<uint32_t, 256> steps;
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        steps[gray] = static_cast<uint32_t>(std::pow(gray / 255.0, brightness) * top * 256);
+    }
+    size_t column = 0;
+    quantise(values.data(), sample_columns, sample_lines, steps, top, dithering, [&](uint32_t step)
+             {
+        *out++ = charset_glyphs[step];
+        if (++column == sample_columns)
+        {
+            *out++ = '\n';
+            column = 0;
+        } });
+    next_line = sample_lines;
+}
+
+void AsciiConverter::convertImageCells(const unsigned char *data, unsigned int height, bool area, bool colored, Dithering dithering)
+{
+    const size_t sample_columns = transform.columns(), sample_lines = transform.lines();
+    PooledBuffer<unsigned char> values(sample_columns * sample_lines);
+    samples(data, height, area, tone, values.data());
+
+    // 1 if the brightness curve of the sample is above its mean over the image, a flat image is lit from the half up
+    std::array<size_t, 256> histogram{};
+    for (size_t i = 0; i < sample_columns * sample_lines; ++i)
+    {
+        ++histogram[values[i]];
+    }
+    std::array<double, 256> levels;
+    double mean = 0;
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        levels[gray] = std::pow(gray / 255.0, brightness);
+        mean += levels[gray] * histogram[gray];
+    }
+    mean /= std::max<size_t>(sample_columns * sample_lines, 1);
+    // without dithering the step is 1 for the lit levels, the dithering spreads the levels around the mean over the step
+    std::array<uint32_t, 256> steps;
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        const bool lit = levels[gray] > mean + 1e-9 || (levels[gray] >= mean - 1e-9 && levels[gray] >= 0.5);
+        steps[gray] = dithering == Dithering::None ? lit * 256 : std::lround(std::min(std::max(levels[gray] - mean + 0.5, 0.0), 1.0) * 256);
+    }
+    // the samples become the bits of the dots
+    unsigned char *bit = values.data();
+    quantise(values.data(), sample_columns, sample_lines, steps, 1, dithering, [&bit](uint32_t step)
+             { *bit++ = step; });
+
+    const unsigned int height_cells = lines(), width_cells = columns();
+    for (unsigned int y = 0; y < height_cells; ++y)
+    {
+        if (cells == CellMode::Braille)
+        {
+            // the rows below the image are read from the first row of the cell and masked off
+            const unsigned char *rows[4];
+            unsigned int valid = 0;
+            for (unsigned int r = 0; r < 4; ++r)
+            {
+                const size_t row = 4 * static_cast<size_t>(y) + r;
+                rows[r] = &values[(row < sample_lines ? row : 4 * static_cast<size_t>(y)) * sample_columns];
+                valid |= row < sample_lines ? BRAILLE_ROWS[r] : 0;
+            }
+            for (unsigned int x = 0; x < width_cells; ++x)
+            {
+                const size_t left = 2 * static_cast<size_t>(x), right = std::min(left + 1, sample_columns - 1);
+                const unsigned int mask = valid & (left + 1 < sample_columns ? 0xFF : BRAILLE_LEFT);
+                const unsigned int bits = (rows[0][left] | rows[1][left] << 1 | rows[2][left] << 2 | rows[0][right] << 3 |
+                                           rows[1][right] << 4 | rows[2][right] << 5 | rows[3][left] << 6 | rows[3][right] << 7) &
+                                          mask;
+                // U+2800 + bits
+                *out++ = '\xE2';
+                *out++ = static_cast<char>(0xA0 | bits >> 6);
+                *out++ = static_cast<char>(0x80 | (bits & 0x3F));
+            }
+        }
+        else
+        {
+            const unsigned char *upper = &values[2 * static_cast<size_t>(y) * sample_columns];
+            const bool has_lower = 2 * static_cast<size_t>(y) + 1 < sample_lines;
+            const unsigned char *lower = has_lower ? upper + sample_columns : upper;
+            const unsigned int valid = has_lower ? 3 : 1;
+            for (unsigned int x = 0; x < width_cells; ++x)
+            {
+                const unsigned int bits = colored ? 1 : (upper[x] | lower[x] << 1) & valid;
+                // the padding of the shorter glyph is overwritten by the next cell (or the line end)
+                std::memcpy(out, HALF_BLOCKS[bits], 4);
+                out += HALF_BLOCK_LENGTHS[bits];
+            }
+        }
+        *out++ = '\n';
+    }
+    ascii_image.resize(out - ascii_image.data());
+    next_line = height_cells;
+}
+
+void AsciiConverter::cellColors(const unsigned char *plane, unsigned int height, bool area, unsigned char *colors, unsigned char *backgrounds) const
+{
+    const size_t sample_columns = transform.columns(), sample_lines = transform.lines();
+    PooledBuffer<unsigned char> values(sample_columns * sample_lines);
+    samples(plane, height, area, nullptr, values.data());
+
+    const size_t width = cellColumns(cells), height_samples = cellRows(cells);
+    for (size_t y = 0; y < lines(); ++y)
+    {
+        const size_t first_row = y * height_samples, last_row = std::min(first_row + height_samples, sample_lines);
+        for (size_t x = 0; x < columns(); ++x)
+        {
+            const size_t first_column = x * width, last_column = std::min(first_column + width, sample_columns);
+            if (backgrounds)
+            { // the lower half of the last line of an odd number of samples repeats the upper one
+                *colors++ = values[first_row * sample_columns + first_column];
+                *backgrounds++ = values[(last_row - 1) * sample_columns + first_column];
+                continue;
+            }
+            unsigned int sum = 0;
+            for (size_t row = first_row; row < last_row; ++row)
+            {
+                for (size_t column = first_column; column < last_column; ++column)
+                {
+                    sum += values[row * sample_columns + column];
+                }
+            }
+            const unsigned int count = (last_row - first_row) * (last_column - first_column);
+            *colors++ = (sum + count / 2) / count;
+        }
+    }
+}
+
+unsigned int AsciiConverter::columns() const
+{
+    return (transform.columns() + cellColumns(cells) - 1) / cellColumns(cells);
+}
+
+unsigned int AsciiConverter::lines() const
+{
+    return (transform.lines() + cellRows(cells) - 1) / cellRows(cells);
+}
+
+void AsciiConverter::sampleCells(const unsigned char *plane, unsigned char *cells) const
+{
+    for (size_t line : transform.lineOffsets())
+    {
+        const unsigned char *row = plane + line;
+        for (size_t column : transform.columnOffsets())
+        {
+            *cells++ = row[column];
+        }
+    }
+}
+
+void AsciiConverter::averageCells(const unsigned char *plane, unsigned int height, unsigned char *cells, const ToneCurve *curve) const
+{
+    const size_t stride = transform.width() + 1;
+    PooledBuffer<uint64_t> sums(stride * (height + 1));
+    summedArea(plane, height, curve, sums.data());
+
+    const std::vector<Transform::Span> &lines = transform.lineSpans();
+    const std::vector<Transform::Span> &columns = transform.columnSpans();
+    const bool swap = transform.swapsAxes();
+    for (const Transform::Span &line : lines)
+    {
+        for (const Transform::Span &column : columns)
+        {
+            const Transform::Span &xs = swap ? line : column;
+            const Transform::Span &ys = swap ? column : line;
+            uint64_t sum = sums[ys.last * stride + xs.last] - sums[ys.first * stride + xs.last]
+                         - sums[ys.last * stride + xs.first] + sums[ys.first * stride + xs.first];
+            uint64_t area = static_cast<uint64_t>(xs.last - xs.first) * (ys.last - ys.first);
+            *cells++ = (sum + area / 2) / area;
+        }
+    }
+}
+
+void AsciiConverter::samples(const unsigned char *plane, unsigned int height, bool area, const ToneCurve *curve, unsigned char *values) const
+{
+    if (area)
+    {
+        averageCells(plane, height, values, curve);
+        return;
+    }
+    sampleCells(plane, values);
+    if (curve)
+    {
+        for (size_t i = 0; i < static_cast<size_t>(transform.columns()) * transform.lines(); ++i)
+        {
+            values[i] = (*curve)[values[i]];
+        }
+    }
+}
+
+void AsciiConverter::summedArea(const unsigned char *plane, unsigned int height, const ToneCurve *curve, uint64_t *sums) const
+{
+    const size_t width = transform.width(), stride = width + 1;
+    std::fill(sums, sums + stride, 0);
+    for (size_t y = 0; y < height; ++y)
+    {
+        const unsigned char *row = plane + y * width;
+        const uint64_t *above = &sums[y * stride];
+        uint64_t *current = &sums[(y + 1) * stride];
+        uint64_t row_sum = 0;
+        current[0] = 0;
+        if (curve)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                row_sum += (*curve)[row[x]];
+                current[x + 1] = above[x + 1] + row_sum;
+            }
+        }
+        else
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                row_sum += row[x];
+                current[x + 1] = above[x + 1] + row_sum;
+            }
+        }
+    }
+}
+
+AsciiConverter::Blocks AsciiConverter::divide(const Transform::Span &span, bool mirrored)
+{
+    const unsigned int SIZE = GlyphMasks::MASK_SIZE, length = span.last - span.first;
+    const unsigned int distinct = std::min(length, SIZE);
+    Blocks blocks;
+    blocks.count = distinct + 1;
+    for (unsigned int i = 0; i <= distinct; ++i)
+    {
+        blocks.points[i] = length >= SIZE ? (mirrored ? span.last - (SIZE - i) * length / SIZE : span.first + i * length / SIZE) : span.first + i;
+    }
+    std::fill(blocks.rows, blocks.rows + SIZE, 0);
+    std::fill(blocks.columns, blocks.columns + SIZE, 0);
+    for (unsigned int k = 0; k < SIZE; ++k)
+    {
+        unsigned int i = length >= SIZE ? k : (mirrored ? length - 1 - (SIZE - 1 - k) * length / SIZE : k * length / SIZE);
+        blocks.rows[i] |= uint64_t(0xFF) << GlyphMasks::bit(k, 0);
+        blocks.columns[i] |= uint64_t(0x0101010101010101) << GlyphMasks::bit(0, k);
+    }
+    for (unsigned int i = 0; i < distinct; ++i)
+    {
+        blocks.inverse[i] = 1.0f / (blocks.points[i + 1] - blocks.points[i]);
+    }
+    return blocks;
+}
+
+int AsciiConverter::nextRow() const
+{
+    if (next_line >= transform.lines())
+    {
+        return -1;
+    }
+    return transform.sourceRow(next_line);
+}
+
+void AsciiConverter::convertRow(const unsigned char *row)
+{
+    for (size_t column : transform.columnOffsets())
+    {
+        *out++ = (*table)[row[column]];
+    }
+    *out++ = '\n';
+    next_line++;
+}
@@ -0,0 +1,205 @@
+#ifndef ASCII_ART_ASCIICONVERTER_HPP
+#define ASCII_ART_ASCIICONVERTER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "GlyphMasks.hpp"
+#include "GlyphTable.hpp"
+#include "ToneCurve.hpp"
+#include "Transform.hpp"
+
+/**
+ * @brief Converts the gray pixels to lines of the ascii image
+ *
+ * @details The source pixel of every cell is given by the Transform (nearest-neighbour sampling of the rotated, flipped and scaled image).
+ * The whole image can be converted at once (convertImage), or, if the transform is row local, row by row as the rows come
+ * from the decoder (nextRow, convertRow) while only the current row is kept in memory.
+ * The area sampling (convertImageArea) averages the whole cell instead, it needs the whole image.
+ * The shape matching (convertImageShapes) compares the structure of the cell with the shapes of the glyphs.
+ * In the braille and half block modes (convertImageCells) the transform gives the samples, several of them are packed
+ * to a single cell of UTF-8 text.
+ */
+class AsciiConverter
+{
+public:
+    /**
+     * @brief Construct a new AsciiConverter and prepare the output string
+     * @param transform The transform mapping the output cells to the source pixels
+     * @param charset The charset (density) to use for the ascii image (must outlive the converter)
+     * @param brightness The brightness to apply to the image
+     * @param ascii_image The string the ascii image is written to, it is resized to the final size (to the longest possible text of the cells)
+     * @param tone The tone curve applied to the gray pixels before the brightness, nullptr if there is none (must outlive the converter)
+     * @param cells What the cells are made of, the charset is not used for the braille and half block cells
+     */
+    AsciiConverter(const Transform &transform, const std::string &charset, double brightness, std::string &ascii_image, const ToneCurve *tone = nullptr,
+                   CellMode cells = CellMode::Charset);
+
+    AsciiConverter(const AsciiConverter &) = delete;
+    AsciiConverter &operator=(const AsciiConverter &) = delete;
+
+    /**
+     * @brief Convert the whole image
+     * @param data Pixels of the decoded image
+     */
+    void convertImage(const unsigned char *data);
+
+    /**
+     * @brief Convert the whole image, every cell gets the mean of all source pixels it covers
+     * @details The means are computed from a summed-area table of the image built once, so every cell costs four lookups
+     * regardless of its size.
+     * @param data Pixels of the decoded image
+     * @param height Height of the decoded image
+     */
+    void convertImageArea(const unsigned char *data, unsigned int height);
+
+    /**
+     * @brief Convert the whole image, every cell gets the glyph whose shape matches its pixels best
+     * @details The cell is divided to MASK_SIZE x MASK_SIZE blocks averaged from the summed-area table of the image,
+     * the blocks brighter than the middle of the range of the cell form its mask and the glyph with the nearest mask wins
+     * (Hamming distance, ties are broken by the brightness of the glyph). Cells without contrast get the glyph of their
+     * mean, the same one as convertImageArea gives them.
+     * @param data Pixels of the decoded image
+     * @param height Height of the decoded image
+     * @param masks Shapes of the glyphs of the charset
+     */
+    void convertImageShapes(const unsigned char *data, unsigned int height, const GlyphMasks &masks);
+
+    /**
+     * @brief Convert the whole image with the levels of the samples dithered between the neighbouring glyphs
+     * @details The level of every sample (after the tone curve and the brightness) is kept in 1/256 of the step between two
+     * glyphs. The ordered dithering adds the threshold of the position from DitherMatrix and truncates, so a row needs
+     * nothing from the others and the loop has no branches. The error diffusion rounds and passes the error on to the
+     * next sample and to the row below (Floyd-Steinberg), it is serial.
+     * @param data Pixels of the decoded image
+     * @param height Height of the decoded image
+     * @param area Whether the samples are the means of their pixels (area sampling) or the nearest pixels
+     * @param dithering Anything but Dithering::None
+     */
+    void convertImageDithered(const unsigned char *data, unsigned int height, bool area, Dithering dithering);
+
+    /**
+     * @brief Convert the whole image to braille patterns or half blocks
+     * @details The samples of the transform are thresholded at the mean of the brightness curve over the image (so dark and
+     * bright images keep their structure) by a lookup table built from their histogram. The bits of a cell are gathered
+     * from its two (half blocks) or four (braille) sample rows at once without any branches and the UTF-8 bytes of the
+     * cell are written right away. The ascii image is shrunk to the written text at the end.
+     * @param data Pixels of the decoded image
+     * @param height Height of the decoded image
+     * @param area Whether the samples are the means of their pixels (area sampling) or the nearest pixels
+     * @param colored Whether the half blocks are coloured, every cell is then the upper half block and the colours make the picture
+     * @param dithering How the samples are quantised to the dots, the dithering spreads the levels around the mean
+     */
+    void convertImageCells(const unsigned char *data, unsigned int height, bool area, bool colored, Dithering dithering = Dithering::None);
+
+    /**
+     * @brief Get the colours of the braille or half block cells from the plane
+     * @param plane A colour channel of the decoded image
+     * @param height Height of the decoded image
+     * @param area Whether the samples are the means of their pixels
+     * @param colors Output for the colours of the cells (mean of the samples of the braille cell, upper sample of the half block)
+     * @param backgrounds Output for the background colours of the half blocks (lower sample), nullptr for braille
+     */
+    void cellColors(const unsigned char *plane, unsigned int height, bool area, unsigned char *colors, unsigned char *backgrounds) const;
+
+    /**
+     * @brief Get the number of the output columns (cells of a line)
+     */
+    unsigned int columns() const;
+
+    /**
+     * @brief Get the number of the output lines
+     */
+    unsigned int lines() const;
+
+    /**
+     * @brief Take the value of every cell from the plane, the same pixel as convertImage takes the glyph from
+     * @param plane A plane of the decoded image (gray or a colour channel)
+     * @param cells Output for the values of the cells, lines * columns of them without the line ends
+     */
+    void sampleCells(const unsigned char *plane, unsigned char *cells) const;
+
+    /**
+     * @brief Average every cell of the plane, the same pixels as convertImageArea averages for the glyph
+     * @param plane A plane of the decoded image (gray or a colour channel)
+     * @param height Height of the decoded image
+     * @param cells Output for the means of the cells, lines * columns of them without the line ends
+     * @param curve Tone curve the pixels are mapped with before they are averaged, nullptr for none
+     */
+    void averageCells(const unsigned char *plane, unsigned int height, unsigned char *cells, const ToneCurve *curve = nullptr) const;
+
+    /**
+     * @brief Get the source row needed for the next line of the ascii image, the transform must be row local
+     * @return int index of the source row, -1 if the ascii image is complete
+     */
+    int nextRow() const;
+
+    /**
+     * @brief Convert the next line of the ascii image
+     * @param row Pointer the column offsets are relative to, the source row (nextRow()) when converting row by row
+     */
+    void convertRow(const unsigned char *row);
+
+private:
+    /**
+     * @brief Division of the span of a cell to MASK_SIZE blocks along one axis of the source
+     * @details The distinct block i covers [points[i], points[i + 1]). If the span is shorter than MASK_SIZE,
+     * the distinct blocks are its single pixels and some of them are repeated in the mask, so only count - 1 blocks
+     * are averaged and each of them sets all bits of its repetitions.
+     */
+    struct Blocks
+    {
+        unsigned int points[GlyphMasks::MASK_SIZE + 1];
+        unsigned int count;
+        float inverse[GlyphMasks::MASK_SIZE]; // 1 / length of the distinct block
+        uint64_t rows[GlyphMasks::MASK_SIZE]; // bits of the mask rows of the distinct block (the axis of the rows of the mask)
+        uint64_t columns[GlyphMasks::MASK_SIZE]; // bits of the mask columns of the distinct block (the axis of the columns)
+    };
+
+    /**
+     * @brief Divide the span of a cell to the blocks, the same way as if the image was rotated and flipped first
+     * @param span The span of the cell
+     * @param mirrored Whether the output axis runs against the source axis, the blocks are then divided from the last pixel
+     */
+    static Blocks divide(const Transform::Span &span, bool mirrored);
+
+    /**
+     * @brief Take every sample of the transform, the nearest pixel or the mean of the pixels, mapped by the curve if there is one
+     */
+    void samples(const unsigned char *plane, unsigned int height, bool area, const ToneCurve *curve, unsigned char *values) const;
+
+    /**
+     * @brief Build the summed-area table of the plane, sums[y * (width + 1) + x] is the sum of the pixels above and left of [x, y]
+     * (64 bits, the sum of a cell of more than 16M pixels doesn't fit to 32)
+     * @param curve Tone curve the pixels are mapped with, nullptr for none
+     */
+    void summedArea(const unsigned char *plane, unsigned int height, const ToneCurve *curve, uint64_t *sums) const;
+
+    const Transform &transform;
+    const std::string &charset;
+    const ToneCurve *tone;
+
+    /**
+     * @brief Glyphs of the gray levels after the tone curve (means of the area sampling)
+     */
+    std::shared_ptr<const GlyphTable> glyphs;
+
+    /**
+     * @brief Glyphs of the gray levels before the tone curve, built only if there is a curve
+     */
+    std::optional<GlyphTable> fused;
+
+    /**
+     * @brief Glyphs of the source pixels, the tone curve is fused into the lookup (glyphs or fused)
+     */
+    const GlyphTable *table;
+    CellMode cells;
+    double brightness;
+    std::string &ascii_image;
+    unsigned int next_line;
+    char *out;
+};
+
+#endif // ASCII_ART_ASCIICONVERTER_HPP
@@ -0,0 +1,162 @@
+#ifndef ASCII_ART_BUFFERPOOL_HPP
+#define ASCII_ART_BUFFERPOOL_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Pool of reusable buffers, so the images of a batch do not allocate their pixels, rows and tables again and again
+ *
+ * @details A released buffer keeps its capacity and acquire() hands out the smallest released buffer which is big enough,
+ * so once the pool is warm, images of the same (or smaller) dimensions do not touch the heap at all.
+ * The pool keeps at most MAX_BUFFERS buffers and MAX_BYTES bytes, the oldest buffers are freed first. Shared by all threads.
+ *
+ * @tparam T Type of the elements of the buffers
+ */
+template <typename T>
+class BufferPool
+{
+public:
+    static constexpr size_t MAX_BUFFERS = 32;
+    static constexpr size_t MAX_BYTES = 256ull * 1024 * 1024;
+
+    /**
+     * @brief Get the pool shared by the whole program
+     */
+    static BufferPool &shared()
+    {
+        static BufferPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Get a buffer of the size, a released one is reused if it is big enough
+     * @param size Number of the elements
+     * @return std::vector<T> the buffer, the content is unspecified
+     */
+    std::vector<T> acquire(size_t size)
+    {
+        std::vector<T> buffer;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            size_t best = buffers.size();
+            for (size_t i = 0; i < buffers.size(); ++i)
+            {
+                if (buffers[i].capacity() >= size && (best == buffers.size() || buffers[i].capacity() < buffers[best].capacity()))
+                {
+                    best = i;
+                }
+            }
+            if (best < buffers.size())
+            {
+                bytes -= buffers[best].capacity() * sizeof(T);
+                buffer = std::move(buffers[best]);
+                buffers.erase(buffers.begin() + best);
+            }
+        }
+        buffer.resize(size);
+        return buffer;
+    }
+
+    /**
+     * @brief Return the buffer to the pool
+     * @param buffer The buffer, it is taken over by the pool
+     */
+    void release(std::vector<T> buffer)
+    {
+        size_t size = buffer.capacity() * sizeof(T);
+        if (size == 0 || size > MAX_BYTES)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        while (!buffers.empty() && (buffers.size() >= MAX_BUFFERS || bytes + size > MAX_BYTES))
+        {
+            bytes -= buffers.front().capacity() * sizeof(T);
+            buffers.erase(buffers.begin());
+        }
+        bytes += size;
+        buffers.push_back(std::move(buffer));
+    }
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+private:
+    BufferPool() : bytes(0)
+    {
+        // the list of the buffers itself never grows
+        buffers.reserve(MAX_BUFFERS);
+    }
+
+    std::mutex lock;
+    std::vector<std::vector<T>> buffers;
+    size_t bytes;
+};
+
+/**
+ * @brief Buffer of a function drawn from the shared BufferPool and returned to it when it goes out of scope
+ * @tparam T Type of the elements of the buffer
+ */
+template <typename T>
+class PooledBuffer
+{
+public:
+    PooledBuffer() = default;
+
+    explicit PooledBuffer(size_t size) : buffer(BufferPool<T>::shared().acquire(size)) {}
+
+    ~PooledBuffer()
+    {
+        BufferPool<T>::shared().release(std::move(buffer));
+    }
+
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+    /**
+     * @brief Change the size of the buffer, the content is unspecified afterwards
+     * @param size Number of the elements
+     */
+    void resize(size_t size)
+    {
+        if (size > buffer.capacity())
+        {
+            BufferPool<T>::shared().release(std::move(buffer));
+            buffer = BufferPool<T>::shared().acquire(size);
+        }
+        buffer.resize(size);
+    }
+
+    T *data()
+    {
+        return buffer.data();
+    }
+
+    const T *data() const
+    {
+        return buffer.data();
+    }
+
+    size_t size() const
+    {
+        return buffer.size();
+    }
+
+    T &operator[](size_t index)
+    {
+        return buffer[index];
+    }
+
+    const T &operator[](size_t index) const
+    {
+        return buffer[index];
+    }
+
+private:
+    std::vector<T> buffer;
+};
+
+#endif // ASCII_ART_BUFFERPOOL_HPP
@@ -1,11 +1,15 @@
 #include "ConfigManager.hpp"
+#include "Convolution.hpp"
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <filesystem>
 #include <algorithm>
+#include <cstdlib>
+#include <sys/ioctl.h>
+#include <unistd.h>
 
-ConfigManager::ConfigManager(int argc, char *argv[]) : output_file_path(""), output_console(false), output_screen(false), output_file(false)
+ConfigManager::ConfigManager(int argc, char *argv[]) : output_file_path(""), output_console(false), output_screen(false), output_file(false), output_image(false), jobs(0), trace_path(""), cache_dir(""), serve_path(""), slide_memory(0), play_path(""), fps(0), manifest_path("")
 {
     int outCnt = 0, i = 1;
     if (argc < 3)
@@ -65,10 +69,115 @@ ConfigManager::ConfigManager(int argc, char *argv[]) : output_file_path(""), out
             }
             continue;
         }
-
-        if (arg.size() > 5 && (arg.substr(arg.size() - 4) == ".jpg" || arg.substr(arg.size() - 4) == ".png"))
+        else if (arg == "--jobs")
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No jobs value provided.");
+            }
+            std::string value(argv[++i]);
+            size_t num;
+            int jobs_value = std::stoi(value, &num);
+            if (num < value.size() || jobs_value < 1)
+            {
+                throw std::invalid_argument("Invalid jobs value.");
+            }
+            jobs = jobs_value;
+            continue;
+        }
+        else if (arg == "--trace")
         {
-            if (!std::filesystem::exists(arg))
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No trace file specified.");
+            }
+            trace_path = argv[++i];
+            continue;
+        }
+        else if (arg == "--cache-dir")
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No cache directory specified.");
+            }
+            cache_dir = argv[++i];
+            continue;
+        }
+        else if (arg == "--slide-memory")
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No slide memory value provided.");
+            }
+            std::string value(argv[++i]);
+            size_t num;
+            int megabytes = std::stoi(value, &num);
+            if (num < value.size() || megabytes < 1)
+            {
+                throw std::invalid_argument("Invalid slide memory value.");
+            }
+            slide_memory = static_cast<size_t>(megabytes) * 1024 * 1024;
+            continue;
+        }
+        else if (arg == "--serve")
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No socket path specified.");
+            }
+            serve_path = argv[++i];
+            continue;
+        }
+        else if (arg == "--play")
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No frames to play specified.");
+            }
+            play_path = argv[++i];
+            if (play_path != "-" && !std::filesystem::is_directory(play_path))
+            {
+                throw std::invalid_argument("Frame directory does not exist.");
+            }
+            // the frames are configured like an image, the options before and after --play apply to them
+            current_img = Img();
+            current_img.image_path = play_path;
+            images.push_back(current_img);
+            image_positions.push_back(args.size());
+            continue;
+        }
+        else if (arg == "--manifest")
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No manifest file specified.");
+            }
+            manifest_path = argv[++i];
+            if (!std::filesystem::exists(manifest_path))
+            {
+                throw std::invalid_argument("Manifest file does not exist.");
+            }
+            continue;
+        }
+        else if (arg == "--fps")
+        {
+            if (i + 1 >= argc)
+            {
+                throw std::invalid_argument("No fps value provided.");
+            }
+            std::string value(argv[++i]);
+            size_t num;
+            fps = std::stod(value, &num);
+            if (num < value.size() || !(fps > 0 && fps <= 1000))
+            {
+                throw std::invalid_argument("Invalid fps value.");
+            }
+            continue;
+        }
+
+        if (arg == "-" || (arg.size() > 5 && (arg.substr(arg.size() - 4) == ".jpg" || arg.substr(arg.size() - 4) == ".png")))
+        { // "-" is the image from the standard input
+            if (arg != "-" && !std::filesystem::exists(arg))
             {
                 throw std::invalid_argument("Image file does not exist.");
             }
@@ -82,7 +191,23 @@ ConfigManager::ConfigManager(int argc, char *argv[]) : output_file_path(""), out
             args.push_back(arg);
         }
     }
-    if (image_positions.empty())
+    if (!serve_path.empty())
+    { // images and outputs come with the requests
+        if (!image_positions.empty() || !manifest_path.empty() || outCnt > 0)
+        {
+            throw std::invalid_argument("Images and output options can't be used with --serve.");
+        }
+        return;
+    }
+    if (!play_path.empty())
+    { // the frames are the only image and the terminal is the output
+        if (images.size() != 1 || !manifest_path.empty() || outCnt > 0)
+        {
+            throw std::invalid_argument("Images and output options can't be used with --play.");
+        }
+        return;
+    }
+    if (image_positions.empty() && manifest_path.empty())
     {
         throw std::invalid_argument("No image files provided.");
     }
@@ -92,16 +217,22 @@ ConfigManager::ConfigManager(int argc, char *argv[]) : output_file_path(""), out
     }
 }
 
-void ConfigManager::parseConfigFile(const std::string &cfg_path, Img &current_config)
+const std::vector<std::pair<std::string, std::string>> &ConfigManager::readConfigFile(const std::string &cfg_path)
 {
+    auto cached = config_files.find(cfg_path);
+    if (cached != config_files.end())
+    {
+        return cached->second;
+    }
+
     std::ifstream config_file(cfg_path);
     if (!config_file.is_open())
     {
         throw std::invalid_argument("Config file does not exist.");
     }
 
+    std::vector<std::pair<std::string, std::string>> entries;
     std::string line;
-    size_t num;
     int ascii_count = 0;
     while (std::getline(config_file, line))
     {
@@ -128,84 +259,15 @@ void ConfigManager::parseConfigFile(const std::string &cfg_path, Img &current_co
                                          { return !std::isspace(ch); })
                                 .base(),
                             value.end());
-                if (key == "brightness")
-                {
-                    current_config.brightness += std::stod(value, &num);
-                    if (num < value.size())
-                    {
-                        throw std::invalid_argument("Invalid brightness value.");
-                    }
-                }
-                else if (key == "flip")
-                {
-                    if (value == "horizontal")
-                    {
-                        current_config.flip_horizontal = !current_config.flip_horizontal;
-                    }
-                    else if (value == "vertical")
-                    {
-                        current_config.flip_vertical = !current_config.flip_vertical;
-                    }
-                    else
-                    {
-                        throw std::invalid_argument("Invalid flip value.");
-                    }
-                }
-                else if (key == "rotate")
-                {
-                    current_config.rotate = ((current_config.rotate + std::stoi(value, &num)) % 360 + 360) % 360;
-                    if (num < value.size())
-                    {
-                        throw std::invalid_argument("Invalid rotate value.");
-                    }
-                }
-                else if (key == "invert")
-                {
-                    if (value != "true" && value != "false")
-                    {
-                        throw std::invalid_argument("Invalid invert value.");
-                    }
-                    current_config.invert = (value == "true");
-                }
-                else if (key == "scale")
-                {
-                    current_config.scale *= std::stod(value, &num);
-                    if (num < value.size())
-                    {
-                        throw std::invalid_argument("Invalid scale value.");
-                    }
-                }
-                else if (key == "ascii")
+                if (key == "ascii")
                 {
                     ascii_count++;
                     if (ascii_count > 1)
                     {
                         throw std::invalid_argument("Multiple ascii files.");
                     }
-                    if (!std::filesystem::exists(value))
-                    {
-                        throw std::invalid_argument("Ascii file does not exist.");
-                    }
-                    std::ifstream charset_file(value);
-                    if (!charset_file.is_open())
-                    {
-                        throw std::invalid_argument("Unable to open charset (ascii) file.");
-                    }
-                    std::getline(charset_file, current_config.charset);
-                    charset_file.close();
-                }
-                else if (key == "fancy")
-                {
-                    if (value != "true" && value != "false")
-                    {
-                        throw std::invalid_argument("Invalid fancy value.");
-                    }
-                    current_config.fancy = (value == "true");
-                }
-                else
-                {
-                    throw std::invalid_argument("Invalid config key.");
                 }
+                entries.emplace_back(key, value);
             }
             else
             {
@@ -214,41 +276,299 @@ void ConfigManager::parseConfigFile(const std::string &cfg_path, Img &current_co
         }
     }
     config_file.close();
+    return config_files.emplace(cfg_path, std::move(entries)).first->second;
+}
+
+void ConfigManager::parseConfigFile(const std::string &cfg_path, Img &current_config)
+{
+    size_t num;
+    for (const auto &entry : readConfigFile(cfg_path))
+    {
+        const std::string &key = entry.first, &value = entry.second;
+        if (key == "brightness")
+        {
+            current_config.brightness += std::stod(value, &num);
+            if (num < value.size())
+            {
+                throw std::invalid_argument("Invalid brightness value.");
+            }
+        }
+        else if (key == "flip")
+        {
+            if (value == "horizontal")
+            {
+                current_config.flip_horizontal = !current_config.flip_horizontal;
+            }
+            else if (value == "vertical")
+            {
+                current_config.flip_vertical = !current_config.flip_vertical;
+            }
+            else
+            {
+                throw std::invalid_argument("Invalid flip value.");
+            }
+        }
+        else if (key == "rotate")
+        {
+            int angle = std::stoi(value, &num);
+            if (num < value.size() || angle % 90 != 0)
+            {
+                throw std::invalid_argument("Invalid rotate value.");
+            }
+            addRotation(current_config, angle);
+        }
+        else if (key == "invert")
+        {
+            if (value != "true" && value != "false")
+            {
+                throw std::invalid_argument("Invalid invert value.");
+            }
+            current_config.invert = (value == "true");
+        }
+        else if (key == "scale")
+        {
+            current_config.scale *= std::stod(value, &num);
+            if (num < value.size())
+            {
+                throw std::invalid_argument("Invalid scale value.");
+            }
+        }
+        else if (key == "ascii")
+        {
+            current_config.charset = readCharset(value);
+        }
+        else if (key == "fancy")
+        {
+            if (value != "true" && value != "false")
+            {
+                throw std::invalid_argument("Invalid fancy value.");
+            }
+            current_config.fancy = (value == "true");
+        }
+        else if (key == "sampling")
+        {
+            current_config.sampling = parseSampling(value);
+        }
+        else if (key == "cells")
+        {
+            current_config.cells = parseCells(value);
+        }
+        else if (key == "dither")
+        {
+            current_config.dither = parseDither(value);
+        }
+        else if (key == "width")
+        {
+            current_config.columns = parseSize(key, value);
+        }
+        else if (key == "height")
+        {
+            current_config.lines = parseSize(key, value);
+        }
+        else if (key == "aspect")
+        {
+            current_config.cell_aspect = parseAspect(value);
+        }
+        else if (key == "fit-terminal")
+        {
+            if (value != "true" && value != "false")
+            {
+                throw std::invalid_argument("Invalid fit-terminal value.");
+            }
+            if (value == "true")
+            {
+                fitTerminal(current_config);
+            }
+        }
+        else if (key == "color")
+        {
+            current_config.color = parseColor(value);
+        }
+        else if (key == "negate")
+        {
+            if (value != "true" && value != "false")
+            {
+                throw std::invalid_argument("Invalid negate value.");
+            }
+            if (value == "true")
+            {
+                current_config.tone.push_back({ToneOp::Kind::Negate});
+            }
+        }
+        else if (key == "edges")
+        {
+            if (value != "true" && value != "false")
+            {
+                throw std::invalid_argument("Invalid edges value.");
+            }
+            if (value == "true")
+            {
+                addFilter(current_config, {FilterOp::Kind::Edges});
+            }
+        }
+        else if (key == "blur" || key == "sharpen")
+        {
+            addFilter(current_config, parseFilter(key, value));
+        }
+        else if (key == "contrast" || key == "gamma" || key == "levels" || key == "threshold" || key == "posterize")
+        {
+            current_config.tone.push_back(parseTone(key, value));
+        }
+        else
+        {
+            throw std::invalid_argument("Invalid config key.");
+        }
+    }
+}
+
+std::shared_ptr<const std::string> ConfigManager::readCharset(const std::string &charset_path)
+{
+    auto cached = charsets.find(charset_path);
+    if (cached != charsets.end())
+    {
+        return cached->second;
+    }
+
+    if (!std::filesystem::exists(charset_path))
+    {
+        throw std::invalid_argument("Ascii file does not exist.");
+    }
+    std::ifstream charset_file(charset_path);
+    if (!charset_file.is_open())
+    {
+        throw std::invalid_argument("Unable to open charset (ascii) file.");
+    }
+    std::string charset;
+    std::getline(charset_file, charset);
+    charset_file.close();
+    return charsets.emplace(charset_path, std::make_shared<const std::string>(std::move(charset))).first->second;
+}
+
+void ConfigManager::readManifest(const Img &global_config)
+{
+    std::ifstream manifest_file(manifest_path);
+    if (!manifest_file.is_open())
+    {
+        throw std::invalid_argument("Manifest file does not exist.");
+    }
+
+    std::string line;
+    std::vector<std::string> tokens;
+    size_t line_number = 0;
+    while (std::getline(manifest_file, line))
+    {
+        line_number++;
+        tokens.clear();
+        std::istringstream is_line(line);
+        std::string token;
+        while (is_line >> token)
+        {
+            tokens.push_back(token);
+        }
+        if (tokens.empty() || tokens[0][0] == '#')
+        {
+            continue;
+        }
+
+        try
+        {
+            if (!std::filesystem::exists(tokens[0]))
+            {
+                throw std::invalid_argument("Image file does not exist.");
+            }
+            Img current_config = global_config;
+            current_config.image_path = tokens[0];
+            checkArgs(current_config, tokens, 1, tokens.size()); // the overrides of the image
+            images.push_back(std::move(current_config));
+        }
+        catch (std::invalid_argument &e)
+        {
+            std::string message = e.what();
+            if (message == "stoi" || message == "stod")
+            {
+                message = "Incorrect operation value.";
+            }
+            throw std::invalid_argument("Manifest line " + std::to_string(line_number) + ": " + message);
+        }
+    }
+    manifest_file.close();
 }
 
 void ConfigManager::parseCommandLine()
 {
-    size_t siz, idx = 0;
-    for (auto &current_config : images)
+    // the global options (before the first image) are parsed just once, every image starts from a copy of them
+    Img global_config;
+    checkArgs(global_config, args, 0, image_positions.empty() ? args.size() : image_positions[0]);
+
+    for (size_t idx = 0; idx < image_positions.size(); idx++)
     {
+        size_t siz = idx + 1 >= image_positions.size() ? args.size() : image_positions[idx + 1];
+        Img &current_config = images[idx];
+        std::string image_path = std::move(current_config.image_path);
+        current_config = global_config;
+        current_config.image_path = std::move(image_path);
+        checkArgs(current_config, args, image_positions[idx], siz); // local config loading
+    }
 
-        if (idx + 1 >= image_positions.size())
+    if (!manifest_path.empty())
+    {
+        readManifest(global_config);
+    }
+
+    // the font of the screen and the image outputs has no braille or block glyphs
+    if (output_screen || output_image)
+    {
+        for (const Img &img : images)
         {
-            siz = args.size();
+            if (img.cells != CellMode::Charset)
+            {
+                throw std::invalid_argument("Braille and half block cells can be written only to the console or to a file.");
+            }
         }
-        else
+    }
+    // the colours are written only as the escape codes of the console, the other outputs would just decode them for nothing
+    // (and coloured half blocks are all ▀, the picture would be lost)
+    if (!output_console)
+    {
+        for (const Img &img : images)
         {
-            siz = image_positions[idx + 1];
+            if (img.color != ColorMode::None)
+            {
+                throw std::invalid_argument("Colours can be written only to the console.");
+            }
         }
+    }
 
-        checkArgs(current_config, 0, image_positions[0]);     // global config loading
-        checkArgs(current_config, image_positions[idx], siz); // local config loading
-        idx++;
+    for (Img &img : images)
+    {
+        // the shapes of the glyphs are matched to the cells, there are no levels to dither
+        if (img.cells == CellMode::Charset && img.sampling == Sampling::Shape && img.dither != Dithering::None)
+        {
+            throw std::invalid_argument("Dithering can't be used with the shape sampling.");
+        }
+        if (img.cell_aspect <= 0)
+        { // the glyphs of the rendered outputs are placed on a square grid, terminal cells are about twice as tall as wide
+            img.cell_aspect = output_screen || output_image ? 1.0 : DEFAULT_CELL_ASPECT;
+        }
+        if (img.columns > 0 || img.lines > 0)
+        { // the target decides the size, the image must not be shrunk by the decoder before it is fitted
+            img.scale = 1.0;
+        }
     }
 }
 
-void ConfigManager::checkArgs(Img &current_config, size_t min, size_t max)
+void ConfigManager::checkArgs(Img &current_config, const std::vector<std::string> &arguments, size_t min, size_t max)
 {
     for (size_t i = min; i < max; i++)
     {
         size_t num;
-        if (args[i] == "--conf")
+        if (arguments[i] == "--conf")
         {
             if (i + 1 >= max)
             {
                 throw std::invalid_argument("No config file path provided.");
             }
-            std::string cfg_path(args[i + 1]);
+            std::string cfg_path(arguments[i + 1]);
             if (!std::filesystem::exists(cfg_path))
             {
                 throw std::invalid_argument("Config file does not exist.");
@@ -258,44 +578,38 @@ void ConfigManager::checkArgs(Img &current_config, size_t min, size_t max)
             ++i;
             continue;
         }
-        else if (args[i] == "--ascii")
+        else if (arguments[i] == "--ascii")
         {
             if (i + 1 >= max)
             {
                 throw std::invalid_argument("No charset file path provided.");
             }
-            std::ifstream charset_file(args[i + 1]);
-            if (!charset_file.is_open())
-            {
-                throw std::invalid_argument("Unable to open charset (ascii) file.");
-            }
-            std::getline(charset_file, current_config.charset);
-            charset_file.close();
+            current_config.charset = readCharset(arguments[i + 1]);
             ++i;
             continue;
         }
-        else if (args[i] == "--brightness")
+        else if (arguments[i] == "--brightness")
         {
             if (i + 1 >= max)
             {
                 throw std::invalid_argument("No brightness value provided.");
             }
-            current_config.brightness += std::stod(args[i + 1], &num);
-            if (num < args[i + 1].size())
+            current_config.brightness += std::stod(arguments[i + 1], &num);
+            if (num < arguments[i + 1].size())
             {
                 throw std::invalid_argument("Invalid brightness value.");
             }
             ++i;
             continue;
         }
-        else if (args[i] == "--scale")
+        else if (arguments[i] == "--scale")
         {
             if (i + 1 >= max)
             {
                 throw std::invalid_argument("No scale value provided.");
             }
-            double scale_value = std::stod(args[i + 1], &num);
-            if (num < args[i + 1].size())
+            double scale_value = std::stod(arguments[i + 1], &num);
+            if (num < arguments[i + 1].size())
             {
                 throw std::invalid_argument("Invalid scale value.");
             }
@@ -303,41 +617,358 @@ void ConfigManager::checkArgs(Img &current_config, size_t min, size_t max)
             ++i;
             continue;
         }
-        else if (args[i] == "--invert")
+        else if (arguments[i] == "--invert")
         {
             current_config.invert = !current_config.invert;
         }
-        else if (args[i] == "--rotate")
+        else if (arguments[i] == "--rotate")
         {
             if (i + 1 >= max)
             {
                 throw std::invalid_argument("No rotate value provided.");
             }
-            current_config.rotate = ((current_config.rotate + std::stoi(args[i + 1], &num)) % 360 + 360) % 360;
-            if (num < args[i + 1].size())
+            int angle = std::stoi(arguments[i + 1], &num);
+            if (num < arguments[i + 1].size() || angle % 90 != 0)
             {
                 throw std::invalid_argument("Invalid rotate value.");
             }
+            addRotation(current_config, angle);
             ++i;
             continue;
         }
-        else if (args[i] == "--flip-horizontal")
+        else if (arguments[i] == "--flip-horizontal")
         {
             current_config.flip_horizontal = !current_config.flip_horizontal;
         }
-        else if (args[i] == "--flip-vertical")
+        else if (arguments[i] == "--flip-vertical")
         {
             current_config.flip_vertical = !current_config.flip_vertical;
         }
-        else if (args[i] == "--fancy")
+        else if (arguments[i] == "--fancy")
         {
             current_config.fancy = !current_config.fancy;
         }
+        else if (arguments[i] == "--sampling")
+        {
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No sampling value provided.");
+            }
+            current_config.sampling = parseSampling(arguments[i + 1]);
+            ++i;
+            continue;
+        }
+        else if (arguments[i] == "--cells")
+        {
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No cells value provided.");
+            }
+            current_config.cells = parseCells(arguments[i + 1]);
+            ++i;
+            continue;
+        }
+        else if (arguments[i] == "--dither")
+        {
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No dither value provided.");
+            }
+            current_config.dither = parseDither(arguments[i + 1]);
+            ++i;
+            continue;
+        }
+        else if (arguments[i] == "--width" || arguments[i] == "--height")
+        {
+            std::string name = arguments[i].substr(2);
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No " + name + " value provided.");
+            }
+            (name == "width" ? current_config.columns : current_config.lines) = parseSize(name, arguments[i + 1]);
+            ++i;
+            continue;
+        }
+        else if (arguments[i] == "--aspect")
+        {
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No aspect value provided.");
+            }
+            current_config.cell_aspect = parseAspect(arguments[i + 1]);
+            ++i;
+            continue;
+        }
+        else if (arguments[i] == "--fit-terminal")
+        {
+            fitTerminal(current_config);
+        }
+        else if (arguments[i] == "--edges")
+        {
+            addFilter(current_config, {FilterOp::Kind::Edges});
+        }
+        else if (arguments[i] == "--blur" || arguments[i] == "--sharpen")
+        {
+            std::string name = arguments[i].substr(2);
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No " + name + " value provided.");
+            }
+            addFilter(current_config, parseFilter(name, arguments[i + 1]));
+            ++i;
+            continue;
+        }
+        else if (arguments[i] == "--negate")
+        {
+            current_config.tone.push_back({ToneOp::Kind::Negate});
+        }
+        else if (arguments[i] == "--contrast" || arguments[i] == "--gamma" || arguments[i] == "--levels" ||
+                 arguments[i] == "--threshold" || arguments[i] == "--posterize")
+        {
+            std::string name = arguments[i].substr(2);
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No " + name + " value provided.");
+            }
+            current_config.tone.push_back(parseTone(name, arguments[i + 1]));
+            ++i;
+            continue;
+        }
+        else if (arguments[i] == "--color")
+        {
+            if (i + 1 >= max)
+            {
+                throw std::invalid_argument("No color value provided.");
+            }
+            current_config.color = parseColor(arguments[i + 1]);
+            ++i;
+            continue;
+        }
+        else
+        {
+            throw std::invalid_argument("Invalid argument: " + arguments[i]);
+        }
+    }
+}
+
+ColorMode ConfigManager::parseColor(const std::string &value)
+{
+    if (value == "none")
+    {
+        return ColorMode::None;
+    }
+    if (value == "256")
+    {
+        return ColorMode::Palette256;
+    }
+    if (value == "truecolor")
+    {
+        return ColorMode::TrueColor;
+    }
+    throw std::invalid_argument("Invalid color value.");
+}
+
+Sampling ConfigManager::parseSampling(const std::string &value)
+{
+    if (value == "nearest")
+    {
+        return Sampling::Nearest;
+    }
+    if (value == "area")
+    {
+        return Sampling::Area;
+    }
+    if (value == "shape")
+    {
+        return Sampling::Shape;
+    }
+    throw std::invalid_argument("Invalid sampling value.");
+}
+
+CellMode ConfigManager::parseCells(const std::string &value)
+{
+    if (value == "charset")
+    {
+        return CellMode::Charset;
+    }
+    if (value == "braille")
+    {
+        return CellMode::Braille;
+    }
+    if (value == "halfblock")
+    {
+        return CellMode::HalfBlock;
+    }
+    throw std::invalid_argument("Invalid cells value.");
+}
+
+Dithering ConfigManager::parseDither(const std::string &value)
+{
+    if (value == "none")
+    {
+        return Dithering::None;
+    }
+    if (value == "bayer4")
+    {
+        return Dithering::Bayer4;
+    }
+    if (value == "bayer8")
+    {
+        return Dithering::Bayer8;
+    }
+    if (value == "bluenoise")
+    {
+        return Dithering::BlueNoise;
+    }
+    if (value == "diffusion")
+    {
+        return Dithering::Diffusion;
+    }
+    throw std::invalid_argument("Invalid dither value.");
+}
+
+unsigned int ConfigManager::parseSize(const std::string &name, const std::string &value)
+{
+    size_t num;
+    int size = std::stoi(value, &num);
+    if (num < value.size() || size < 1 || size > 10000)
+    {
+        throw std::invalid_argument("Invalid " + name + " value.");
+    }
+    return size;
+}
+
+double ConfigManager::parseAspect(const std::string &value)
+{
+    size_t num;
+    double aspect = std::stod(value, &num);
+    if (num < value.size() || !(aspect > 0) || aspect > 10)
+    {
+        throw std::invalid_argument("Invalid aspect value.");
+    }
+    return aspect;
+}
+
+void ConfigManager::fitTerminal(Img &current_config)
+{
+    unsigned int columns = 0, rows = 0;
+    struct winsize size;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0)
+    {
+        columns = size.ws_col;
+        rows = size.ws_row;
+    }
+    // not a terminal (redirected output, pipes), the shell may still export its size
+    const char *columns_variable = std::getenv("COLUMNS"), *lines_variable = std::getenv("LINES");
+    if (columns == 0 && columns_variable)
+    {
+        columns = std::strtoul(columns_variable, nullptr, 10);
+    }
+    if (rows == 0 && lines_variable)
+    {
+        rows = std::strtoul(lines_variable, nullptr, 10);
+    }
+    current_config.columns = columns > 0 ? std::min(columns, 10000u) : 80;
+    current_config.lines = rows > 1 ? std::min(rows - 1, 10000u) : 23;
+}
+
+ToneOp ConfigManager::parseTone(const std::string &name, const std::string &value)
+{
+    ToneOp operation;
+    size_t num;
+    bool valid;
+    if (name == "levels")
+    { // black:white
+        size_t colon = value.find(':');
+        if (colon == std::string::npos)
+        {
+            throw std::invalid_argument("Invalid levels value.");
+        }
+        std::string black = value.substr(0, colon), white = value.substr(colon + 1);
+        operation.kind = ToneOp::Kind::Levels;
+        operation.first = std::stod(black, &num);
+        valid = num == black.size();
+        operation.second = std::stod(white, &num);
+        valid = valid && num == white.size() && operation.first >= 0 && operation.first < operation.second && operation.second <= 255;
+    }
+    else
+    {
+        operation.first = std::stod(value, &num);
+        valid = num == value.size();
+        if (name == "contrast")
+        {
+            operation.kind = ToneOp::Kind::Contrast;
+            valid = valid && operation.first >= 0;
+        }
+        else if (name == "gamma")
+        {
+            operation.kind = ToneOp::Kind::Gamma;
+            valid = valid && operation.first > 0;
+        }
+        else if (name == "threshold")
+        {
+            operation.kind = ToneOp::Kind::Threshold;
+            valid = valid && operation.first >= 0 && operation.first <= 255;
+        }
         else
         {
-            throw std::invalid_argument("Invalid argument: " + args[i]);
+            operation.kind = ToneOp::Kind::Posterize;
+            valid = valid && operation.first >= 2 && operation.first <= 256 && operation.first == static_cast<int>(operation.first);
+        }
+    }
+    if (!valid)
+    {
+        throw std::invalid_argument("Invalid " + name + " value.");
+    }
+    return operation;
+}
+
+FilterOp ConfigManager::parseFilter(const std::string &name, const std::string &value)
+{
+    FilterOp filter;
+    size_t num;
+    bool valid;
+    if (name == "blur")
+    { // sigma
+        filter.kind = FilterOp::Kind::Blur;
+        filter.sigma = std::stod(value, &num);
+        valid = num == value.size();
+    }
+    else
+    { // amount[:sigma]
+        filter.kind = FilterOp::Kind::Sharpen;
+        size_t colon = value.find(':');
+        std::string amount = value.substr(0, colon);
+        filter.amount = std::stod(amount, &num);
+        valid = num == amount.size() && filter.amount > 0 && filter.amount <= 20;
+        if (colon != std::string::npos)
+        {
+            std::string sigma = value.substr(colon + 1);
+            filter.sigma = std::stod(sigma, &num);
+            valid = valid && num == sigma.size();
         }
     }
+    if (!valid || !(filter.sigma > 0 && filter.sigma <= Convolution::MAX_RADIUS / 3.0))
+    {
+        throw std::invalid_argument("Invalid " + name + " value.");
+    }
+    return filter;
+}
+
+void ConfigManager::addFilter(Img &current_config, FilterOp filter)
+{
+    filter.tone_before = current_config.tone.size();
+    current_config.filters.push_back(filter);
+}
+
+void ConfigManager::addRotation(Img &current_config, int angle)
+{
+    // Img stores "rotate, then flip", rotating an image flipped along one axis turns it the other way
+    if (current_config.flip_horizontal != current_config.flip_vertical)
+    {
+        angle = -angle;
+    }
+    current_config.rotate = ((current_config.rotate + angle) % 360 + 360) % 360;
 }
 
 std::string ConfigManager::getOutputPath() const
@@ -345,11 +976,46 @@ std::string ConfigManager::getOutputPath() const
     return output_file_path;
 }
 
-std::vector<Img> ConfigManager::getImages() const
+const std::vector<Img> &ConfigManager::getImages() const
 {
     return images;
 }
 
+size_t ConfigManager::getJobs() const
+{
+    return jobs;
+}
+
+std::string ConfigManager::getTracePath() const
+{
+    return trace_path;
+}
+
+std::string ConfigManager::getCacheDir() const
+{
+    return cache_dir;
+}
+
+std::string ConfigManager::getServePath() const
+{
+    return serve_path;
+}
+
+std::string ConfigManager::getPlayPath() const
+{
+    return play_path;
+}
+
+double ConfigManager::getFps() const
+{
+    return fps;
+}
+
+size_t ConfigManager::getSlideMemory() const
+{
+    return slide_memory;
+}
+
 std::string ConfigManager::getOutputType() const
 {
     if (output_console)
@@ -1,7 +1,10 @@
 #ifndef ASCII_ART_CONFIGMANAGER_HPP
 #define ASCII_ART_CONFIGMANAGER_HPP
 
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include "ImgOptions.hpp"
 
@@ -32,10 +35,10 @@ public:
     std::string getOutputPath() const;
 
     /**
-     * @brief get vector of configurations for images
-     * @return std::vector<Img> vector of configurations for images
+     * @brief get vector of configurations for images, the images of the command line come first, then the images of the manifest
+     * @return const std::vector<Img>& vector of configurations for images
      */
-    std::vector<Img> getImages() const;
+    const std::vector<Img> &getImages() const;
 
     /**
      * @brief get output option type
@@ -43,6 +46,48 @@ public:
      */
     std::string getOutputType() const;
 
+    /**
+     * @brief get number of threads used for processing the images
+     * @return size_t number of threads, 0 if not specified (hardware thread count is used)
+     */
+    size_t getJobs() const;
+
+    /**
+     * @brief get path to the trace file
+     * @return std::string path to the trace file, empty if tracing is off
+     */
+    std::string getTracePath() const;
+
+    /**
+     * @brief get path to the directory of the cache of converted images
+     * @return std::string path to the cache directory, empty if the cache is off
+     */
+    std::string getCacheDir() const;
+
+    /**
+     * @brief get path to the socket the server listens on
+     * @return std::string path to the socket, empty if not running as a server
+     */
+    std::string getServePath() const;
+
+    /**
+     * @brief get the frames played as an animation
+     * @return std::string directory of the frames or "-" for a PGM / Y4M stream, empty if not playing
+     */
+    std::string getPlayPath() const;
+
+    /**
+     * @brief get frame rate of the animation
+     * @return double frames per second, 0 if not specified (rate of the stream or the default is used)
+     */
+    double getFps() const;
+
+    /**
+     * @brief get limit of the memory of the slide textures of the presentation
+     * @return size_t limit in bytes, 0 if not specified (default limit is used)
+     */
+    size_t getSlideMemory() const;
+
 private:
     /**
      * @brief Parses the config file
@@ -52,14 +97,129 @@ private:
     void parseConfigFile(const std::string &cfg_path, Img &current_config);
 
     /**
-     * @brief Parses the command line arguments within bounds [min, max] for the current image.
+     * @brief Read the key-value lines of the config file, every file is read just once
+     * @param cfg_path path to the config file
+     * @return const std::vector<std::pair<std::string, std::string>>& the keys and values in the order of the file
+     */
+    const std::vector<std::pair<std::string, std::string>> &readConfigFile(const std::string &cfg_path);
+
+    /**
+     * @brief Read the charset (first line) of the charset file, every file is read just once and its charset is shared by all images
+     * @param charset_path path to the charset (ascii) file
+     * @return std::shared_ptr<const std::string> the charset
+     */
+    std::shared_ptr<const std::string> readCharset(const std::string &charset_path);
+
+    /**
+     * @brief Read the images of the manifest, one image per line: the path followed by the options of the image
+     * (same as on the command line), empty lines and lines starting with # are skipped
+     * @param global_config the global configuration the options of every image are applied to
+     */
+    void readManifest(const Img &global_config);
+
+    /**
+     * @brief Parses the arguments within bounds [min, max] for the current image.
      * Uses the image index [min] we saved in the constructor so we can parse the arguments to the correct image ([max] is the next image index).
      *
      * @param current_config Img object to store the parsed configurations
+     * @param arguments the arguments (command line or a line of the manifest)
      * @param min index of the first argument for the current image
      * @param max index of the last argument for the current image
      */
-    void checkArgs(Img &current_config, size_t min, size_t max);
+    void checkArgs(Img &current_config, const std::vector<std::string> &arguments, size_t min, size_t max);
+
+    /**
+     * @brief Rotates the image after the flips given so far, so the order of rotations and flips is kept
+     * @param current_config Img object to store the rotation
+     * @param angle angle of the rotation in degrees (multiple of 90)
+     */
+    void addRotation(Img &current_config, int angle);
+
+    /**
+     * @brief Parse the value of the colour option
+     * @param value none, 256 or truecolor
+     * @return ColorMode the colour mode
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static ColorMode parseColor(const std::string &value);
+
+    /**
+     * @brief Parse the value of the sampling option
+     * @param value nearest, area or shape
+     * @return Sampling the sampling
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static Sampling parseSampling(const std::string &value);
+
+    /**
+     * @brief Parse the value of the cells option
+     * @param value charset, braille or halfblock
+     * @return CellMode the cells of the ascii image
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static CellMode parseCells(const std::string &value);
+
+    /**
+     * @brief Parse the value of the dither option
+     * @param value none, bayer4, bayer8, bluenoise or diffusion
+     * @return Dithering the dithering
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static Dithering parseDither(const std::string &value);
+
+    /**
+     * @brief Parse the number of the columns or the lines the image is fitted to
+     * @param name width or height
+     * @param value the number of the cells, 1 - 10000
+     * @return unsigned int the number of the cells
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static unsigned int parseSize(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Parse the aspect ratio of the output cells
+     * @param value width / height of a cell, (0, 10]
+     * @return double the aspect ratio
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static double parseAspect(const std::string &value);
+
+    /**
+     * @brief Fit the image to the terminal of the standard output, one line is left for the prompt.
+     * The size is read by TIOCGWINSZ, the COLUMNS and LINES variables are used if the output is not a terminal (80 x 24 if unset)
+     * @param current_config Img object to store the columns and the lines
+     */
+    static void fitTerminal(Img &current_config);
+
+    /**
+     * @brief Width / height of a terminal cell, used for the console and the file outputs if no aspect is given
+     */
+    static constexpr double DEFAULT_CELL_ASPECT = 0.5;
+
+    /**
+     * @brief Parse the value of the tone operation
+     * @param name contrast (factor), gamma (exponent), levels (black:white), threshold (gray level) or posterize (number of levels)
+     * @param value the value of the operation
+     * @return ToneOp the operation
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static ToneOp parseTone(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Parse the value of the convolution filter
+     * @param name blur (sigma) or sharpen (amount, optionally amount:sigma)
+     * @param value the value of the filter
+     * @return FilterOp the filter
+     * @throw std::invalid_argument if the value is not valid
+     */
+    static FilterOp parseFilter(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Add the filter after the tone operations given so far, so the order of the filters and the tone operations is kept
+     * @param current_config Img object to store the filter
+     * @param filter The filter
+     */
+    static void addFilter(Img &current_config, FilterOp filter);
 
     /**
      * @brief stores the configuration of images
@@ -96,6 +256,56 @@ private:
      */
     bool output_image;
 
+    /**
+     * @brief number of threads used for processing the images (--jobs), 0 means hardware thread count
+     */
+    size_t jobs;
+
+    /**
+     * @brief path to the file the trace of the processing is written to (--trace), empty if tracing is off
+     */
+    std::string trace_path;
+
+    /**
+     * @brief directory of the persistent cache of converted images (--cache-dir), empty if the cache is off
+     */
+    std::string cache_dir;
+
+    /**
+     * @brief path to the unix socket to serve the conversions on (--serve), empty if not running as a server
+     */
+    std::string serve_path;
+
+    /**
+     * @brief limit of the memory of the slide textures in bytes (--slide-memory in megabytes), 0 means default
+     */
+    size_t slide_memory;
+
+    /**
+     * @brief directory of the frames or "-" for a stream on the standard input (--play), empty if not playing
+     */
+    std::string play_path;
+
+    /**
+     * @brief frames per second of the animation (--fps), 0 means the rate of the stream or the default
+     */
+    double fps;
+
+    /**
+     * @brief path to the manifest with the images and their options (--manifest), empty if not specified
+     */
+    std::string manifest_path;
+
+    /**
+     * @brief key-value lines of the config files read so far, by path
+     */
+    std::map<std::string, std::vector<std::pair<std::string, std::string>>> config_files;
+
+    /**
+     * @brief charsets of the charset files read so far, by path
+     */
+    std::map<std::string, std::shared_ptr<const std::string>> charsets;
+
     /**
      * @brief stores the index of the images in the command line arguments
      */
@@ -1,16 +1,21 @@
 #include "Controller.hpp"
 #include <iostream>
-#include "ImagePNG.hpp"
-#include "ImageJPG.hpp"
 #include "OutputPresentation.hpp"
 #include "OutputFile.hpp"
 #include "OutputImage.hpp"
 #include <algorithm>
-#include "FilterFlip.hpp"
-#include "FilterRotate.hpp"
+#include "Transform.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include "Trace.hpp"
+#include "AsciiCache.hpp"
+#include "AnsiText.hpp"
+#include "Server.hpp"
+#include "FrameSource.hpp"
+#include "Player.hpp"
 
 Controller::Controller(int argc, char *argv[])
-try : config(argc, argv)
+try : config(argc, argv), shared_pool(nullptr)
 {
     config.parseCommandLine();
     run();
@@ -19,93 +24,217 @@ catch (std::exception &e)
 {
 }
 
+Controller::Controller(int argc, char *argv[], ThreadPool &pool) : config(argc, argv), shared_pool(&pool)
+{
+    config.parseCommandLine();
+}
+
 void Controller::run()
 {
-    if (!loadImages())
+    if (!config.getServePath().empty())
     {
-        std::cout << "Error while loading images." << std::endl;
+        Server server(config.getServePath(), config.getJobs());
+        if (!server.run())
+        {
+            std::cout << "Error while serving on " << config.getServePath() << "." << std::endl;
+        }
         return;
     }
-    applyFilters();
-    convertToAscii();
-    outputImages();
+
+    if (!config.getTracePath().empty())
+    {
+        Trace::enable(config.getTracePath());
+    }
+
+    if (!config.getPlayPath().empty())
+    {
+        playFrames();
+    }
+    else if (!processImages())
+    {
+        std::cout << "Error while loading images." << std::endl;
+    }
+    else
+    {
+        outputImages();
+    }
+
+    if (!Trace::write())
+    {
+        std::cout << "Error while writing the trace." << std::endl;
+    }
 }
 
-bool Controller::loadImages()
+bool Controller::processImages()
 {
-    for (auto &img : config.getImages())
+    images.clear();
+    images.reserve(config.getImages().size());
+    for (Img img : config.getImages())
     {
-        if (img.image_path.find(".png") != std::string::npos)
-        {
-            images.emplace_back(std::make_unique<ImagePNG>(), img);
-        }
-        else if (img.image_path.find(".jpg") != std::string::npos)
+        if (img.scale < 0.0 || img.scale > 10.0)
         {
-            images.emplace_back(std::make_unique<ImageJPG>(), img);
+            std::cout << "Invalid scale value, using default: 1.0" << std::endl;
+            img.scale = 1.0;
         }
-        else
+        images.emplace_back(nullptr, img);
+    }
+
+    std::vector<char> loaded(images.size(), false); // std::vector<bool> can't be written from multiple threads
+    std::atomic<bool> failed(false);
+    std::unique_ptr<AsciiCache> cache;
+    if (!config.getCacheDir().empty())
+    {
+        cache = std::make_unique<AsciiCache>(config.getCacheDir());
+    }
+    std::unique_ptr<ThreadPool> own_pool;
+    if (!shared_pool)
+    {
+        own_pool = std::make_unique<ThreadPool>(config.getJobs());
+    }
+    ThreadPool &pool = shared_pool ? *shared_pool : *own_pool;
+
+    // the standard input can be read just once, all "-" images share it
+    std::unique_ptr<ImageSource> input;
+    if (std::any_of(images.begin(), images.end(), [](const auto &image)
+                    { return image.second.image_path == "-"; }))
+    {
+        input = ImageSource::fromStdin();
+        if (!input)
         {
             return false;
         }
-        if (!images.back().first->load(img.image_path, img.invert))
+    }
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        pool.submit([this, i, &loaded, &failed, &cache, &input]
+                    {
+            if (failed)
+            {
+                return;
+            }
+            try
+            {
+                auto &image = images[i];
+                Trace::Span span("image", image.second.image_path, image.second.scale);
+                std::unique_ptr<ImageSource> file;
+                const ImageSource *source = input.get();
+                if (image.second.image_path != "-")
+                {
+                    file = ImageSource::fromFile(image.second.image_path);
+                    source = file.get();
+                }
+                if (!source)
+                {
+                    failed = true;
+                    return;
+                }
+
+                std::string key = cache ? cache->key(*source, image.second) : "";
+                bool cached = !key.empty() && createImage(image, *source) && cache->load(key, *image.first);
+                if (cached)
+                { // neither decoded nor converted
+                    loaded[i] = true;
+                }
+                else if (Transform::isRowLocal(image.second) && image.second.sampling == Sampling::Nearest && image.second.cells == CellMode::Charset && image.second.dither == Dithering::None && image.second.color == ColorMode::None && image.second.filters.empty())
+                {
+                    loaded[i] = streamImage(image, *source);
+                }
+                else if (loadImage(image, *source))
+                {
+                    loaded[i] = true;
+                    convertToAscii(image);
+                }
+                if (loaded[i] && !cached && !key.empty())
+                {
+                    cache->store(key, *image.first);
+                }
+                failed = failed || !loaded[i];
+                if (image.first)
+                {
+                    span.setSize(image.first->width, image.first->height);
+                }
+            }
+            catch (std::exception &e)
+            {
+                loaded[i] = false;
+                failed = true;
+            } });
+    }
+    pool.wait();
+    if (cache)
+    {
+        cache->evict();
+    }
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (!loaded[i])
         {
             return false;
         }
-        std::cout << "Loaded: " << img.image_path << std::endl;
+        std::cout << "Loaded: " << images[i].second.image_path << std::endl;
     }
     return true;
 }
 
-void Controller::applyFilters()
+void Controller::playFrames()
 {
-    std::vector<Filter *> filters;
-    for (auto &image : images)
+    Img img = config.getImages().front();
+    if (img.scale < 0.0 || img.scale > 10.0)
     {
+        std::cout << "Invalid scale value, using default: 1.0" << std::endl;
+        img.scale = 1.0;
+    }
+    std::unique_ptr<FrameSource> frames = FrameSource::open(config.getPlayPath());
+    if (!frames)
+    {
+        std::cout << "Error while opening the frames." << std::endl;
+        return;
+    }
+    Player player(std::move(frames), img, config.getFps());
+    if (!player.run())
+    {
+        std::cout << "Error while reading the frames." << std::endl;
+    }
+}
 
-        if (image.second.rotate)
-        {
-            filters.push_back(new FilterRotate());
-        }
-
-        if (image.second.flip_horizontal || image.second.flip_vertical)
-        {
-            filters.push_back(new FilterFlip());
-        }
+bool Controller::createImage(std::pair<std::unique_ptr<Image>, Img> &image, const ImageSource &source) const
+{
+    image.first = Image::create(source);
+    return image.first != nullptr;
+}
 
-        for (Filter *filter : filters)
-        {
-            filter->apply(image);
-        }
+bool Controller::loadImage(std::pair<std::unique_ptr<Image>, Img> &image, const ImageSource &source) const
+{
+    const Img &img = image.second;
+    return createImage(image, source) && image.first->load(source, img.invert, img.scale, img.color != ColorMode::None);
+}
 
-        for (Filter *filter : filters)
-        {
-            delete filter;
-        }
-        filters.clear();
-    }
+bool Controller::streamImage(std::pair<std::unique_ptr<Image>, Img> &image, const ImageSource &source) const
+{
+    const Img &img = image.second;
+    return createImage(image, source) && image.first->loadAscii(source, img);
 }
 
-void Controller::convertToAscii()
+void Controller::convertToAscii(std::pair<std::unique_ptr<Image>, Img> &image) const
 {
-    for (auto &image : images)
-    {
-        if (image.second.scale < 0.0 || image.second.scale > 10.0)
-        {
-            std::cout << "Invalid scale value, using default: 1.0" << std::endl;
-            image.second.scale = 1.0;
-        }
-        image.first->imgToAscii(image.second.scale, image.second.charset, image.second.brightness);
-    }
+    image.first->imgToAscii(image.second);
+
+    // only the ascii image is needed from now on, the pixels are reused by the next image
+    image.first->releasePixels();
 }
 
 void Controller::outputImages()
 {
+    Trace::Span span("Controller::outputImages");
     std::string out = config.getOutputType();
     std::unique_ptr<Output> output;
 
     if (out == "screen")
     {
-        output = std::make_unique<OutputPresentation>();
+        size_t memory_limit = config.getSlideMemory();
+        output = std::make_unique<OutputPresentation>(memory_limit ? memory_limit : SlideCache::DEFAULT_MEMORY_LIMIT);
     }
     else if (out == "file")
     {
@@ -115,12 +244,20 @@ void Controller::outputImages()
     {
         for (auto &image : images)
         {
-            std::cout << image.first->ascii_image << std::endl;
+            Trace::Span span("Controller::writeConsole", image.second.image_path, image.second.scale);
+            if (image.second.color == ColorMode::None)
+            {
+                std::cout << image.first->ascii_image << std::endl;
+            }
+            else
+            {
+                std::cout << AnsiText::render(*image.first, image.second.color) << std::endl;
+            }
         }
     }
     else if (out == "image")
     {
-        output = std::make_unique<OutputImage>();
+        output = std::make_unique<OutputImage>(config.getJobs());
     }
     else
     {
@@ -137,4 +274,14 @@ void Controller::outputImages()
             return;
         }
     }
+}
+
+std::string Controller::getOutputType() const
+{
+    return config.getOutputType();
+}
+
+const std::vector<std::pair<std::unique_ptr<Image>, Img>> &Controller::getImages() const
+{
+    return images;
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 #define ASCII_ART_CONTROLLER_HPP
 #include <string>
 #include <memory>
-#include "Filter.hpp"
+#include "Image.hpp"
+#include "ImageSource.hpp"
 #include "ConfigManager.hpp"
+#include "ThreadPool.hpp"
 
 /**
  * @brief Controller class that handles the flow of the program
@@ -19,31 +21,79 @@ public:
     Controller(int argc, char *argv[]);
 
     /**
-     * @brief Run the program - load images, apply filters, convert to ascii, and output images
+     * @brief Construct a new Controller object for a single request of the server, nothing is run yet
+     * @param argc The number of arguments of the request
+     * @param argv The arguments of the request
+     * @param pool The pool of the server the images are processed on
+     */
+    Controller(int argc, char *argv[], ThreadPool &pool);
+
+    /**
+     * @brief Run the program - process images (load, convert to ascii) and output them
      */
     void run();
 
     /**
-     * @brief Load images from the vector of image configuration we initialized in the ConfigManager
+     * @brief Process all images from the vector of image configuration we initialized in the ConfigManager.
+     * Every image is an independent task (load -> ascii) running on a thread pool, the order of the images is kept.
+     * Images whose transform is row local are streamed, the others (rotated, flipped vertically, area sampled or shape matched, braille or half block cells, dithered, coloured, filtered) are loaded to memory first.
+     * The image files are mapped to memory, the image "-" is read from the standard input.
+     * @return true if all images were loaded successfully, false otherwise
+     */
+    bool processImages();
+
+    /**
+     * @brief Play the frames (--play) as an ascii animation in the terminal, see Player
+     */
+    void playFrames();
+
+    /**
+     * @brief Create the image object according to the format detected from the magic bytes of the source
+     * @param image The image and its configuration
+     * @param source The bytes of the encoded image
+     * @return true if the format is supported, false otherwise
+     */
+    bool createImage(std::pair<std::unique_ptr<Image>, Img> &image, const ImageSource &source) const;
+
+    /**
+     * @brief Load single image to memory
+     * @param image The image and its configuration
+     * @param source The bytes of the encoded image
      * @return true if image was loaded successfully, false otherwise
      */
-    bool loadImages();
+    bool loadImage(std::pair<std::unique_ptr<Image>, Img> &image, const ImageSource &source) const;
 
     /**
-     * @brief Apply filters to the images
+     * @brief Decode single image and convert it to ascii row by row, the pixels are never kept in memory as a whole
+     * @param image The image and its configuration
+     * @param source The bytes of the encoded image
+     * @return true if image was loaded and converted successfully, false otherwise
      */
-    void applyFilters();
+    bool streamImage(std::pair<std::unique_ptr<Image>, Img> &image, const ImageSource &source) const;
 
     /**
-     * @brief Convert images to ascii
+     * @brief Convert single image to ascii
+     * @param image The image and its configuration
      */
-    void convertToAscii();
+    void convertToAscii(std::pair<std::unique_ptr<Image>, Img> &image) const;
 
     /**
      * @brief Output images the way the user specified in the command line
      */
     void outputImages();
 
+    /**
+     * @brief Get the output option type
+     * @return std::string output option type
+     */
+    std::string getOutputType() const;
+
+    /**
+     * @brief Get the processed images
+     * @return const std::vector<std::pair<std::unique_ptr<Image>, Img>>& the images and their configurations
+     */
+    const std::vector<std::pair<std::unique_ptr<Image>, Img>> &getImages() const;
+
 private:
     /**
      * @brief ConfigManager object that handles the configuration of the program
@@ -54,6 +104,11 @@ private:
      * @brief Vector of pairs of unique_ptr to Image and Img object, so we have the image data and its configuration
      */
     std::vector<std::pair<std::unique_ptr<Image>, Img>> images;
+
+    /**
+     * @brief Pool shared with the server, nullptr if the controller creates its own one
+     */
+    ThreadPool *shared_pool;
 };
 
 #endif // ASCII_ART_CONTROLLER_HPP
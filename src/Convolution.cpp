@@ -0,0 +1,239 @@
+#include "Convolution.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include "BufferPool.hpp"
+#include "ToneCurve.hpp"
+#include "Trace.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    /**
+     * @brief Copy the row with the edge pixels repeated radius times on both sides
+     */
+    void padRow(const unsigned char *row, unsigned int width, int radius, unsigned char *padded)
+    {
+        std::fill(padded, padded + radius, row[0]);
+        std::copy(row, row + width, padded + radius);
+        std::fill(padded + radius + width, padded + 2 * radius + width, row[width - 1]);
+    }
+
+    /**
+     * @brief out[x] = sum of weights[k] * padded[x + k], the weights sum to 256 so the sums fit to 16 bits
+     */
+    void horizontalPass(const unsigned char *padded, unsigned int width, const uint16_t *weights, int taps, uint16_t *out)
+    {
+        unsigned int x = 0;
+#if defined(__SSE2__)
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i sum = _mm_setzero_si128();
+            for (int k = 0; k < taps; ++k)
+            {
+                __m128i source = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(padded + x + k)), zero);
+                sum = _mm_add_epi16(sum, _mm_mullo_epi16(source, _mm_set1_epi16(weights[k])));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), sum);
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            unsigned int sum = 0;
+            for (int k = 0; k < taps; ++k)
+            {
+                sum += weights[k] * padded[x + k];
+            }
+            out[x] = sum;
+        }
+    }
+
+    /**
+     * @brief out[x] = sum of weights[k] * rows[k][x] rounded back to 8 bits (both passes together scale by 65536)
+     */
+    void verticalPass(const uint16_t *const *rows, unsigned int width, const uint16_t *weights, int taps, unsigned char *out)
+    {
+        unsigned int x = 0;
+#if defined(__SSE2__)
+        const __m128i rounding = _mm_set1_epi32(32768);
+        for (; x + 8 <= width; x += 8)
+        {
+            __m128i low = rounding, high = rounding;
+            for (int k = 0; k < taps; ++k)
+            { // 16 x 16 -> 32-bit products from the low and high halves
+                __m128i source = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rows[k] + x));
+                __m128i weight = _mm_set1_epi16(weights[k]);
+                __m128i product_low = _mm_mullo_epi16(source, weight), product_high = _mm_mulhi_epu16(source, weight);
+                low = _mm_add_epi32(low, _mm_unpacklo_epi16(product_low, product_high));
+                high = _mm_add_epi32(high, _mm_unpackhi_epi16(product_low, product_high));
+            }
+            __m128i result = _mm_packs_epi32(_mm_srli_epi32(low, 16), _mm_srli_epi32(high, 16));
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(result, result));
+        }
+#endif
+        for (; x < width; ++x)
+        {
+            uint32_t sum = 32768;
+            for (int k = 0; k < taps; ++k)
+            {
+                sum += static_cast<uint32_t>(weights[k]) * rows[k][x];
+            }
+            out[x] = sum >> 16;
+        }
+    }
+}
+
+Convolution::Kernel::Kernel(double sigma) : radius(std::min(std::max(static_cast<int>(std::ceil(3 * sigma)), 1), MAX_RADIUS)), weights{}
+{
+    const int taps = 2 * radius + 1;
+    std::array<double, 2 * MAX_RADIUS + 2> cumulative{};
+    for (int i = 0; i < taps; ++i)
+    {
+        double distance = static_cast<double>(i) - radius;
+        cumulative[i + 1] = cumulative[i] + std::exp(-distance * distance / (2 * sigma * sigma));
+    }
+    // rounding the cumulative sums keeps the total exactly 256 and no weight negative
+    for (int i = 0; i < taps; ++i)
+    {
+        weights[i] = std::lround(256 * cumulative[i + 1] / cumulative[taps]) - std::lround(256 * cumulative[i] / cumulative[taps]);
+    }
+}
+
+void Convolution::apply(const std::vector<FilterOp> &filters, const std::vector<ToneOp> &tone, double scale,
+                        const unsigned char *pixels, unsigned int width, unsigned int height, unsigned char *result)
+{
+    const size_t size = static_cast<size_t>(width) * height;
+    if (filters.empty() || size == 0)
+    {
+        std::copy(pixels, pixels + size, result);
+        return;
+    }
+
+    // a pass of the tone operations before a filter is a stage as well
+    size_t stages = 0, applied = 0;
+    for (const FilterOp &filter : filters)
+    {
+        const size_t before = std::min(filter.tone_before, tone.size());
+        stages += before > applied ? 2 : 1;
+        applied = std::max(applied, before);
+    }
+
+    // the stages alternate between the result and this buffer, so that the last one writes to the result
+    PooledBuffer<unsigned char> between(stages > 1 ? size : 0);
+    const unsigned char *input = pixels;
+    auto nextOutput = [&]
+    {
+        --stages;
+        return stages % 2 == 0 ? result : between.data();
+    };
+    applied = 0;
+    for (const FilterOp &filter : filters)
+    {
+        const size_t before = std::min(filter.tone_before, tone.size());
+        if (before > applied)
+        {
+            Trace::Span span("Convolution::tone");
+            ToneCurve curve(tone.begin() + applied, tone.begin() + before);
+            unsigned char *output = nextOutput();
+            for (size_t i = 0; i < size; ++i)
+            {
+                output[i] = curve[input[i]];
+            }
+            input = output;
+            applied = before;
+        }
+
+        unsigned char *output = nextOutput();
+        if (filter.kind == FilterOp::Kind::Edges)
+        {
+            Trace::Span span("Convolution::edges");
+            sobel(input, width, height, output);
+        }
+        else if (filter.kind == FilterOp::Kind::Sharpen)
+        { // the decoder may have shrunk the image, the blur covers the same part of it
+            Trace::Span span("Convolution::sharpen");
+            gaussian(Kernel(filter.sigma * scale), filter.amount, input, width, height, output);
+        }
+        else
+        {
+            Trace::Span span("Convolution::blur");
+            gaussian(Kernel(filter.sigma * scale), 0, input, width, height, output);
+        }
+        input = output;
+    }
+}
+
+void Convolution::gaussian(const Kernel &kernel, double amount, const unsigned char *pixels, unsigned int width, unsigned int height, unsigned char *result)
+{
+    const int radius = kernel.radius, taps = 2 * radius + 1;
+    PooledBuffer<unsigned char> padded(width + 2 * radius);
+    PooledBuffer<unsigned char> blurred(amount > 0 ? width : 0);
+    // horizontally filtered rows y - radius ... y + radius of the output row y, row r is in the slot r mod taps
+    PooledBuffer<uint16_t> ring(static_cast<size_t>(taps) * width);
+    PooledBuffer<const uint16_t *> rows(taps);
+
+    auto slot = [taps](int y)
+    {
+        return static_cast<size_t>((y % taps + taps) % taps);
+    };
+    auto filterRow = [&](int y)
+    {
+        int source = std::min(std::max(y, 0), static_cast<int>(height) - 1);
+        padRow(pixels + static_cast<size_t>(source) * width, width, radius, padded.data());
+        horizontalPass(padded.data(), width, kernel.weights.data(), taps, &ring[slot(y) * width]);
+    };
+
+    for (int y = -radius; y < radius; ++y)
+    {
+        filterRow(y);
+    }
+    const int amount_fixed = static_cast<int>(std::lround(amount * 256));
+    for (int y = 0; y < static_cast<int>(height); ++y)
+    {
+        filterRow(y + radius);
+        for (int k = 0; k < taps; ++k)
+        {
+            rows[k] = &ring[slot(y - radius + k) * width];
+        }
+
+        unsigned char *out = result + static_cast<size_t>(y) * width;
+        if (amount <= 0)
+        {
+            verticalPass(rows.data(), width, kernel.weights.data(), taps, out);
+            continue;
+        }
+        // unsharp mask, the difference from the blurred row is amplified
+        verticalPass(rows.data(), width, kernel.weights.data(), taps, blurred.data());
+        const unsigned char *source = pixels + static_cast<size_t>(y) * width;
+        for (unsigned int x = 0; x < width; ++x)
+        {
+            int value = source[x] + (source[x] - blurred[x]) * amount_fixed / 256;
+            out[x] = std::min(std::max(value, 0), 255);
+        }
+    }
+}
+
+void Convolution::sobel(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned char *result)
+{
+    const size_t stride = width + 2;
+    PooledBuffer<unsigned char> padded(3 * stride);
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            int source = std::min(std::max(static_cast<int>(y) - 1 + k, 0), static_cast<int>(height) - 1);
+            padRow(pixels + static_cast<size_t>(source) * width, width, 1, &padded[k * stride]);
+        }
+        const unsigned char *above = padded.data(), *row = above + stride, *below = row + stride;
+        unsigned char *out = result + static_cast<size_t>(y) * width;
+        for (unsigned int x = 0; x < width; ++x)
+        { // the pixel x is at x + 1 of the padded rows
+            int gx = (above[x + 2] - above[x]) + 2 * (row[x + 2] - row[x]) + (below[x + 2] - below[x]);
+            int gy = (below[x] + 2 * below[x + 1] + below[x + 2]) - (above[x] + 2 * above[x + 1] + above[x + 2]);
+            out[x] = std::min((std::abs(gx) + std::abs(gy)) / 4, 255);
+        }
+    }
+}
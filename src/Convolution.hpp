@@ -0,0 +1,65 @@
+#ifndef ASCII_ART_CONVOLUTION_HPP
+#define ASCII_ART_CONVOLUTION_HPP
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "ImgOptions.hpp"
+
+/**
+ * @brief Convolution filters of the gray pixels: gaussian blur, sharpening (unsharp mask) and Sobel edges
+ *
+ * @details The gaussian kernel is separable, every row is filtered horizontally just once into a ring of 2 * radius + 1
+ * rows, which stays in the cache, and the output row is filtered vertically from the ring right away. The unsharp mask
+ * combines the blurred row with the source row in the same pass. The weights are 8-bit fixed point (the horizontal
+ * pass keeps 16 bits per pixel), the inner loops run on 8 (SSE2) pixels at once.
+ *
+ * The tone operations given before a filter are applied to the pixels in their place, so the order of the arguments is kept
+ * even if the operations don't commute. The pixels out of the image are the nearest edge pixels.
+ * The filters run on the calling thread, the images themselves are converted in parallel.
+ */
+class Convolution
+{
+public:
+    /**
+     * @brief Apply the filters one after another, each after the tone operations given before it
+     * @param filters The filters in the order they are applied
+     * @param tone The tone operations of the image, the ones after the last filter are left to the caller
+     * @param scale Size of the pixels relative to the original image (Image::decoded_scale), sigma is in the original pixels
+     * @param pixels The gray pixels of the image
+     * @param width Width of the image
+     * @param height Height of the image
+     * @param result Output for the filtered pixels, width * height of them (may not be the same as pixels)
+     */
+    static void apply(const std::vector<FilterOp> &filters, const std::vector<ToneOp> &tone, double scale,
+                      const unsigned char *pixels, unsigned int width, unsigned int height, unsigned char *result);
+
+    /**
+     * @brief Largest radius of the gaussian kernel, sigma is limited to a third of it
+     */
+    static constexpr int MAX_RADIUS = 48;
+
+private:
+    /**
+     * @brief Gaussian kernel of 2 * radius + 1 weights summing to 256, stored in place so a filter doesn't allocate
+     */
+    struct Kernel
+    {
+        explicit Kernel(double sigma);
+
+        int radius;
+        std::array<uint16_t, 2 * MAX_RADIUS + 1> weights;
+    };
+
+    /**
+     * @brief Blur (or sharpen, amount > 0) the image
+     */
+    static void gaussian(const Kernel &kernel, double amount, const unsigned char *pixels, unsigned int width, unsigned int height, unsigned char *result);
+
+    /**
+     * @brief Compute the gradient magnitude of the image
+     */
+    static void sobel(const unsigned char *pixels, unsigned int width, unsigned int height, unsigned char *result);
+};
+
+#endif // ASCII_ART_CONVOLUTION_HPP
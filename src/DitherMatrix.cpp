@@ -0,0 +1,170 @@
+#include "DitherMatrix.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+    /**
+     * @brief Standard deviation of the gaussian measuring the density of the blue-noise pattern around a position
+     */
+    const double ENERGY_SIGMA = 1.5;
+
+    /**
+     * @brief Share of the positions set in the initial blue-noise pattern
+     */
+    const unsigned int INITIAL_DENSITY = 10;
+}
+
+DitherMatrix::DitherMatrix(unsigned int size, const std::vector<unsigned int> &ranks) : size(size), thresholds(ranks.size())
+{
+    const size_t count = ranks.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        thresholds[i] = (2 * ranks[i] + 1) * 128 / count;
+    }
+}
+
+const DitherMatrix &DitherMatrix::get(Dithering dithering)
+{
+    static const DitherMatrix bayer4(4, bayer(4));
+    static const DitherMatrix bayer8(8, bayer(8));
+    if (dithering == Dithering::Bayer4)
+    {
+        return bayer4;
+    }
+    if (dithering == Dithering::Bayer8)
+    {
+        return bayer8;
+    }
+    // built on the first use only, it takes a while
+    static const DitherMatrix blue_noise(BLUE_NOISE_SIZE, blueNoise(BLUE_NOISE_SIZE));
+    return blue_noise;
+}
+
+std::vector<unsigned int> DitherMatrix::bayer(unsigned int size)
+{
+    // every quadrant of the doubled matrix takes every fourth rank, in the order top left, bottom right, top right, bottom left
+    std::vector<unsigned int> ranks{0};
+    for (unsigned int half = 1; half < size; half *= 2)
+    {
+        const unsigned int width = 2 * half;
+        std::vector<unsigned int> doubled(static_cast<size_t>(width) * width);
+        for (unsigned int y = 0; y < half; ++y)
+        {
+            for (unsigned int x = 0; x < half; ++x)
+            {
+                const unsigned int rank = 4 * ranks[y * half + x];
+                doubled[y * width + x] = rank;
+                doubled[y * width + x + half] = rank + 2;
+                doubled[(y + half) * width + x] = rank + 3;
+                doubled[(y + half) * width + x + half] = rank + 1;
+            }
+        }
+        ranks.swap(doubled);
+    }
+    return ranks;
+}
+
+std::vector<unsigned int> DitherMatrix::blueNoise(unsigned int size)
+{
+    const size_t count = static_cast<size_t>(size) * size;
+    // gaussian of the distance on the torus, indexed by the offset of the positions
+    std::vector<double> kernel(count);
+    for (unsigned int dy = 0; dy < size; ++dy)
+    {
+        for (unsigned int dx = 0; dx < size; ++dx)
+        {
+            const double wy = std::min(dy, size - dy), wx = std::min(dx, size - dx);
+            kernel[dy * size + dx] = std::exp(-(wx * wx + wy * wy) / (2 * ENERGY_SIGMA * ENERGY_SIGMA));
+        }
+    }
+
+    // energy of a position is the density of the set positions around it
+    std::vector<unsigned char> pattern(count, 0);
+    std::vector<double> energy(count, 0.0);
+    auto toggle = [&](size_t position)
+    {
+        pattern[position] ^= 1;
+        const double sign = pattern[position] ? 1 : -1;
+        const unsigned int py = position / size, px = position % size;
+        for (unsigned int y = 0; y < size; ++y)
+        {
+            const double *row = &kernel[((y + size - py) % size) * size];
+            for (unsigned int x = 0; x < size; ++x)
+            {
+                energy[y * size + x] += sign * row[(x + size - px) % size];
+            }
+        }
+    };
+    // the tightest cluster is the set position with the highest energy, the largest void the free one with the lowest
+    auto tightestCluster = [&]
+    {
+        size_t best = count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (pattern[i] && (best == count || energy[i] > energy[best]))
+            {
+                best = i;
+            }
+        }
+        return best;
+    };
+    auto largestVoid = [&]
+    {
+        size_t best = count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!pattern[i] && (best == count || energy[i] < energy[best]))
+            {
+                best = i;
+            }
+        }
+        return best;
+    };
+
+    // random initial pattern (fixed seed, the matrix is always the same), then the clusters move to the voids until it is even
+    uint32_t seed = 12345;
+    const size_t initial = count / INITIAL_DENSITY;
+    for (size_t set = 0; set < initial;)
+    {
+        seed = seed * 1664525 + 1013904223;
+        const size_t position = (seed >> 8) % count;
+        if (!pattern[position])
+        {
+            toggle(position);
+            ++set;
+        }
+    }
+    for (size_t step = 0; step < count; ++step)
+    {
+        const size_t cluster = tightestCluster();
+        toggle(cluster);
+        const size_t gap = largestVoid();
+        toggle(gap);
+        if (gap == cluster)
+        {
+            break;
+        }
+    }
+
+    // the initial positions get the low ranks from the tightest cluster down, the others the high ranks from the largest void up
+    std::vector<unsigned int> ranks(count);
+    const std::vector<unsigned char> initial_pattern = pattern;
+    const std::vector<double> initial_energy = energy;
+    for (size_t rank = initial; rank > 0; --rank)
+    {
+        const size_t cluster = tightestCluster();
+        ranks[cluster] = rank - 1;
+        toggle(cluster);
+    }
+    pattern = initial_pattern;
+    energy = initial_energy;
+    for (size_t rank = initial; rank < count; ++rank)
+    {
+        const size_t gap = largestVoid();
+        ranks[gap] = rank;
+        toggle(gap);
+    }
+    return ranks;
+}
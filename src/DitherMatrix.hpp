@@ -0,0 +1,67 @@
+#ifndef ASCII_ART_DITHERMATRIX_HPP
+#define ASCII_ART_DITHERMATRIX_HPP
+
+#include <vector>
+#include "ImgOptions.hpp"
+
+/**
+ * @brief Threshold offsets of the ordered dithering, a square matrix tiled over the output cells
+ *
+ * @details The matrix ranks its positions 0 ... size * size - 1, the rank r becomes the threshold (2r + 1) * 128 / (size * size)
+ * in 1/256 of a quantisation step, so the thresholds are spread evenly over the step and a flat area averages to its
+ * exact level. The Bayer matrices are built recursively, the blue-noise matrix by the void-and-cluster method on
+ * a torus (so its tiles join without seams). The threshold depends only on the position of the cell, every row is
+ * quantised independently of the others.
+ * Matrices are immutable and built once (DitherMatrix::get), they are shared by all images and threads.
+ */
+class DitherMatrix
+{
+public:
+    /**
+     * @brief Size of the blue-noise matrix
+     */
+    static constexpr unsigned int BLUE_NOISE_SIZE = 32;
+
+    /**
+     * @brief Get the shared matrix of the ordered dithering
+     * @param dithering Bayer4, Bayer8 or BlueNoise
+     */
+    static const DitherMatrix &get(Dithering dithering);
+
+    /**
+     * @brief Get the thresholds (0 - 255) of the row of the matrix the output row y uses, the column x uses the element x & mask()
+     */
+    const unsigned char *row(size_t y) const
+    {
+        return &thresholds[(y & mask()) * size];
+    }
+
+    /**
+     * @brief Get the mask of the coordinates, the size is a power of two
+     */
+    size_t mask() const
+    {
+        return size - 1;
+    }
+
+private:
+    /**
+     * @brief Build the thresholds from the ranks of the positions (row by row)
+     */
+    DitherMatrix(unsigned int size, const std::vector<unsigned int> &ranks);
+
+    /**
+     * @brief Rank the positions of the Bayer matrix of the size (a power of two)
+     */
+    static std::vector<unsigned int> bayer(unsigned int size);
+
+    /**
+     * @brief Rank the positions by the void-and-cluster method, every prefix of the ranking is evenly spread
+     */
+    static std::vector<unsigned int> blueNoise(unsigned int size);
+
+    unsigned int size;
+    std::vector<unsigned char> thresholds;
+};
+
+#endif // ASCII_ART_DITHERMATRIX_HPP
@@ -0,0 +1,515 @@
+#include "FrameSource.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include "BufferPool.hpp"
+#include "ImageSource.hpp"
+#include "Transform.hpp"
+
+namespace
+{
+    /**
+     * @brief Frame whose pixels are filled in by the stream, there is nothing to decode
+     */
+    class RawFrame : public Image
+    {
+    public:
+        RawFrame(unsigned int width, unsigned int height) : Image(width, height) {}
+
+    protected:
+        bool decode(const ImageSource &, bool, double, bool, const RowCallback &) override
+        {
+            return false;
+        }
+    };
+
+    /**
+     * @brief Compare the names so the numbers in them are compared by their value (frame2 < frame10)
+     */
+    bool naturalLess(const std::string &a, const std::string &b)
+    {
+        size_t i = 0, j = 0;
+        while (i < a.size() && j < b.size())
+        {
+            if (std::isdigit(static_cast<unsigned char>(a[i])) && std::isdigit(static_cast<unsigned char>(b[j])))
+            {
+                size_t start_a = i, start_b = j;
+                while (i < a.size() && std::isdigit(static_cast<unsigned char>(a[i])))
+                {
+                    ++i;
+                }
+                while (j < b.size() && std::isdigit(static_cast<unsigned char>(b[j])))
+                {
+                    ++j;
+                }
+                // leading zeros don't change the value
+                std::string number_a = a.substr(start_a, i - start_a), number_b = b.substr(start_b, j - start_b);
+                number_a.erase(0, std::min(number_a.find_first_not_of('0'), number_a.size()));
+                number_b.erase(0, std::min(number_b.find_first_not_of('0'), number_b.size()));
+                if (number_a.size() != number_b.size())
+                {
+                    return number_a.size() < number_b.size();
+                }
+                if (number_a != number_b)
+                {
+                    return number_a < number_b;
+                }
+            }
+            else
+            {
+                if (a[i] != b[j])
+                {
+                    return a[i] < b[j];
+                }
+                ++i;
+                ++j;
+            }
+        }
+        return a.size() - i < b.size() - j;
+    }
+
+    /**
+     * @brief Images of a directory in the natural order of their names, files which are not images are skipped
+     */
+    class DirectorySource : public FrameSource
+    {
+    public:
+        explicit DirectorySource(std::vector<std::string> files) : files(std::move(files)), current(0) {}
+
+        std::unique_ptr<Image> next(const Img &img) override
+        {
+            while (current < files.size())
+            {
+                std::unique_ptr<ImageSource> source = ImageSource::fromFile(files[current++]);
+                if (!source)
+                {
+                    error = true;
+                    return nullptr;
+                }
+                std::unique_ptr<Image> frame = Image::create(*source);
+                if (!frame)
+                {
+                    continue;
+                }
+
+                if (Transform::isRowLocal(img) && img.sampling == Sampling::Nearest && img.cells == CellMode::Charset && img.dither == Dithering::None && img.filters.empty())
+                {
+                    if (!frame->loadAscii(*source, img))
+                    {
+                        error = true;
+                        return nullptr;
+                    }
+                    return frame;
+                }
+                if (!frame->load(*source, img.invert, img.scale))
+                {
+                    error = true;
+                    return nullptr;
+                }
+                frame->imgToAscii(img);
+                frame->releasePixels();
+                return frame;
+            }
+            return nullptr;
+        }
+
+        bool skip() override
+        {
+            if (current >= files.size())
+            {
+                return false;
+            }
+            ++current;
+            return true;
+        }
+
+    private:
+        std::vector<std::string> files;
+        size_t current;
+    };
+
+    /**
+     * @brief Concatenated binary PGM images or a Y4M stream, read sequentially (pipes can't seek)
+     */
+    class StreamSource : public FrameSource
+    {
+    public:
+        enum class Kind
+        {
+            PGM,
+            Y4M
+        };
+
+        /**
+         * @brief Detect the kind of the stream, the Y4M stream header is parsed right away
+         * @return std::unique_ptr<StreamSource> the stream, nullptr if the stream is not supported
+         */
+        static std::unique_ptr<StreamSource> open(std::FILE *input)
+        {
+            char magic[2];
+            if (std::fread(magic, 1, 2, input) != 2)
+            {
+                return nullptr;
+            }
+            if (magic[0] == 'P' && magic[1] == '5')
+            {
+                return std::unique_ptr<StreamSource>(new StreamSource(input, Kind::PGM));
+            }
+
+            std::string header;
+            if (magic[0] != 'Y' || magic[1] != 'U' || !readLine(input, header) || header.compare(0, 8, "V4MPEG2 ") != 0)
+            {
+                return nullptr;
+            }
+            std::unique_ptr<StreamSource> stream(new StreamSource(input, Kind::Y4M));
+            if (!stream->parseStreamHeader(header.substr(8)))
+            {
+                return nullptr;
+            }
+            return stream;
+        }
+
+        std::unique_ptr<Image> next(const Img &img) override
+        {
+            if (!readFrameHeader())
+            {
+                return nullptr;
+            }
+
+            auto frame = std::make_unique<RawFrame>(width, height);
+            const size_t pixels = static_cast<size_t>(width) * height;
+            frame->data = BufferPool<unsigned char>::shared().acquire(pixels);
+            if (!readSamples(frame->data.data(), pixels) || !skipBytes(chroma_size))
+            {
+                error = true;
+                return nullptr;
+            }
+            if (img.invert)
+            {
+                for (unsigned char &pixel : frame->data)
+                {
+                    pixel = 255 - pixel;
+                }
+            }
+            frame->imgToAscii(img);
+            frame->releasePixels();
+            return frame;
+        }
+
+        bool skip() override
+        {
+            if (!readFrameHeader())
+            {
+                return false;
+            }
+            const size_t sample_size = maxval > 255 ? 2 : 1;
+            if (!skipBytes(static_cast<size_t>(width) * height * sample_size + chroma_size))
+            {
+                error = true;
+                return false;
+            }
+            return true;
+        }
+
+        double fps() const override
+        {
+            return stream_fps;
+        }
+
+    private:
+        StreamSource(std::FILE *input, Kind kind) : input(input), kind(kind), width(0), height(0), maxval(255), chroma_size(0), stream_fps(0), magic_read(true) {}
+
+        /**
+         * @brief Read the line without the line end
+         * @return false at the end of the input or if the line is too long to be a header
+         */
+        static bool readLine(std::FILE *input, std::string &line)
+        {
+            line.clear();
+            int c;
+            while ((c = std::getc(input)) != EOF && c != '\n')
+            {
+                if (line.size() >= 4096)
+                {
+                    return false;
+                }
+                line += static_cast<char>(c);
+            }
+            return c == '\n';
+        }
+
+        /**
+         * @brief Parse the number of the Y4M header, only digits are allowed and the value is bounded the same as in readNumber
+         */
+        static bool parseNumber(const std::string &value, unsigned int &number)
+        {
+            if (value.empty() || value.size() > 9 ||
+                !std::all_of(value.begin(), value.end(), [](unsigned char c)
+                             { return std::isdigit(c); }))
+            {
+                return false;
+            }
+            number = std::stoul(value);
+            return true;
+        }
+
+        /**
+         * @brief Parse the parameters of the Y4M stream header (W, H, F, C), the others are ignored
+         */
+        bool parseStreamHeader(const std::string &parameters)
+        {
+            std::string colorspace = "420";
+            size_t position = 0;
+            while (position < parameters.size())
+            {
+                size_t end = parameters.find(' ', position);
+                if (end == std::string::npos)
+                {
+                    end = parameters.size();
+                }
+                std::string parameter = parameters.substr(position, end - position);
+                position = end + 1;
+                if (parameter.size() < 2)
+                {
+                    continue;
+                }
+                std::string value = parameter.substr(1);
+                switch (parameter[0])
+                {
+                case 'W':
+                    if (!parseNumber(value, width))
+                    {
+                        return false;
+                    }
+                    break;
+                case 'H':
+                    if (!parseNumber(value, height))
+                    {
+                        return false;
+                    }
+                    break;
+                case 'F':
+                { // numerator:denominator
+                    size_t colon = value.find(':');
+                    unsigned int numerator, denominator = 1;
+                    if (!parseNumber(value.substr(0, colon), numerator) ||
+                        (colon != std::string::npos && !parseNumber(value.substr(colon + 1), denominator)))
+                    {
+                        return false;
+                    }
+                    stream_fps = denominator > 0 ? static_cast<double>(numerator) / denominator : 0;
+                    break;
+                }
+                case 'C':
+                    colorspace = value;
+                    break;
+                }
+            }
+            if (width == 0 || height == 0)
+            {
+                return false;
+            }
+
+            // only the luma plane is used, the chroma planes which follow it are skipped
+            const size_t half_width = (width + 1) / 2, half_height = (height + 1) / 2;
+            if (colorspace == "mono")
+            {
+                chroma_size = 0;
+            }
+            else if (colorspace == "420" || colorspace == "420jpeg" || colorspace == "420mpeg2" || colorspace == "420paldv")
+            {
+                chroma_size = 2 * half_width * half_height;
+            }
+            else if (colorspace == "422")
+            {
+                chroma_size = 2 * half_width * height;
+            }
+            else if (colorspace == "411")
+            {
+                chroma_size = 2 * ((width + 3) / 4) * static_cast<size_t>(height);
+            }
+            else if (colorspace == "444")
+            {
+                chroma_size = 2 * static_cast<size_t>(width) * height;
+            }
+            else if (colorspace == "444alpha")
+            {
+                chroma_size = 3 * static_cast<size_t>(width) * height;
+            }
+            else
+            { // more than 8 bits per sample
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Read the header of the next frame (FRAME line of Y4M, magic, dimensions and maxval of PGM)
+         * @return false at the end of the stream or if the header is broken (the error is set)
+         */
+        bool readFrameHeader()
+        {
+            if (error)
+            {
+                return false;
+            }
+            if (kind == Kind::Y4M)
+            {
+                std::string line;
+                if (!readLine(input, line))
+                {
+                    error = !line.empty();
+                    return false;
+                }
+                error = line.compare(0, 5, "FRAME") != 0;
+                return !error;
+            }
+
+            if (!magic_read)
+            {
+                int p = std::getc(input);
+                if (p == EOF)
+                {
+                    return false;
+                }
+                if (p != 'P' || std::getc(input) != '5')
+                {
+                    error = true;
+                    return false;
+                }
+            }
+            magic_read = false;
+            unsigned int frame_width, frame_height;
+            if (!readNumber(frame_width) || !readNumber(frame_height) || !readNumber(maxval) ||
+                frame_width == 0 || frame_height == 0 || maxval == 0 || maxval > 65535)
+            {
+                error = true;
+                return false;
+            }
+            width = frame_width;
+            height = frame_height;
+            return true;
+        }
+
+        /**
+         * @brief Read the number of the PGM header, whitespace and comments before it are skipped and
+         * the single whitespace after it is consumed
+         */
+        bool readNumber(unsigned int &number)
+        {
+            int c = std::getc(input);
+            while (c == '#' || std::isspace(c))
+            {
+                if (c == '#')
+                {
+                    while (c != EOF && c != '\n')
+                    {
+                        c = std::getc(input);
+                    }
+                }
+                c = std::getc(input);
+            }
+            if (!std::isdigit(c))
+            {
+                return false;
+            }
+            number = 0;
+            while (std::isdigit(c) && number < 100000000)
+            {
+                number = number * 10 + (c - '0');
+                c = std::getc(input);
+            }
+            return std::isspace(c);
+        }
+
+        /**
+         * @brief Read the samples of the gray plane, samples of other depths than 8 bits are scaled to 0 - 255
+         */
+        bool readSamples(unsigned char *pixels, size_t count)
+        {
+            if (maxval == 255)
+            {
+                return std::fread(pixels, 1, count, input) == count;
+            }
+            if (maxval < 256)
+            {
+                if (std::fread(pixels, 1, count, input) != count)
+                {
+                    return false;
+                }
+                for (size_t i = 0; i < count; ++i)
+                {
+                    pixels[i] = std::min<unsigned int>(pixels[i], maxval) * 255 / maxval;
+                }
+                return true;
+            }
+
+            // two bytes per sample, the most significant first
+            PooledBuffer<unsigned char> samples(count * 2);
+            if (std::fread(samples.data(), 1, count * 2, input) != count * 2)
+            {
+                return false;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                unsigned int value = samples[2 * i] << 8 | samples[2 * i + 1];
+                pixels[i] = std::min(value, maxval) * 255 / maxval;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Read and throw away the bytes (the chroma planes, skipped frames)
+         */
+        bool skipBytes(size_t count)
+        {
+            unsigned char chunk[64 * 1024];
+            while (count > 0)
+            {
+                size_t length = std::min(count, sizeof(chunk));
+                if (std::fread(chunk, 1, length, input) != length)
+                {
+                    return false;
+                }
+                count -= length;
+            }
+            return true;
+        }
+
+        std::FILE *input;
+        Kind kind;
+        unsigned int width;
+        unsigned int height;
+        unsigned int maxval;
+        size_t chroma_size;
+        double stream_fps;
+        bool magic_read; // the magic of the first PGM frame was consumed by the detection
+    };
+}
+
+std::unique_ptr<FrameSource> FrameSource::open(const std::string &path)
+{
+    if (path == "-")
+    {
+        return StreamSource::open(stdin);
+    }
+
+    std::error_code error;
+    std::vector<std::string> files;
+    for (const auto &entry : std::filesystem::directory_iterator(path, error))
+    {
+        if (entry.is_regular_file(error))
+        {
+            files.push_back(entry.path().string());
+        }
+    }
+    if (error)
+    {
+        return nullptr;
+    }
+    std::sort(files.begin(), files.end(), naturalLess);
+    return std::make_unique<DirectorySource>(std::move(files));
+}
@@ -0,0 +1,65 @@
+#ifndef ASCII_ART_FRAMESOURCE_HPP
+#define ASCII_ART_FRAMESOURCE_HPP
+
+#include <memory>
+#include <string>
+#include "Image.hpp"
+#include "ImgOptions.hpp"
+
+/**
+ * @brief "Abstract" sequence of the frames of an animation, read one frame after another
+ *
+ * @details The frames are either the images (png, jpg) of a directory played in the natural order of their names
+ * (frame2.png before frame10.png), or a raw stream on the standard input - concatenated binary PGM images (P5)
+ * or a YUV4MPEG2 (Y4M) stream, whose luma plane is used as the gray image. Raw frames are read straight to a pooled
+ * buffer, nothing has to be decoded.
+ */
+class FrameSource
+{
+public:
+    virtual ~FrameSource() = default;
+
+    /**
+     * @brief Open the frames of the directory, "-" reads a PGM or Y4M stream from the standard input
+     * @param path The path to the directory or "-"
+     * @return std::unique_ptr<FrameSource> the frames, nullptr if they can't be opened
+     */
+    static std::unique_ptr<FrameSource> open(const std::string &path);
+
+    /**
+     * @brief Read the next frame and convert it to ascii, the pixels are released afterwards
+     * @param img Configuration of the conversion (invert, scale, charset, brightness, rotation, flips and sampling)
+     * @return std::unique_ptr<Image> the converted frame, nullptr at the end of the sequence or on an error
+     */
+    virtual std::unique_ptr<Image> next(const Img &img) = 0;
+
+    /**
+     * @brief Skip the next frame without decoding and converting it
+     * @return true if there was a frame to skip
+     */
+    virtual bool skip() = 0;
+
+    /**
+     * @brief Get the frame rate stored in the stream
+     * @return double frames per second, 0 if the frames don't have one
+     */
+    virtual double fps() const
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Get whether the sequence was cut short by an error (unreadable frame, broken stream)
+     */
+    bool failed() const
+    {
+        return error;
+    }
+
+protected:
+    FrameSource() : error(false) {}
+
+    bool error;
+};
+
+#endif // ASCII_ART_FRAMESOURCE_HPP
@@ -0,0 +1,144 @@
+#include "GlyphAtlas.hpp"
+#include <algorithm>
+#include <map>
+#include <memory>
+
+GlyphAtlas::GlyphAtlas(TTF_Font *font) : font(font), cell_width(1), cell_height(1), atlas_renderer(nullptr), atlas_texture(nullptr)
+{
+    int advance = 0;
+    if (TTF_GlyphMetrics(font, 'M', nullptr, nullptr, nullptr, nullptr, &advance) == 0)
+    {
+        cell_width = std::max(advance, 1);
+    }
+    cell_height = std::max(TTF_FontHeight(font), 1);
+    uploaded.fill(false);
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    if (atlas_texture)
+    {
+        SDL_DestroyTexture(atlas_texture);
+    }
+    TTF_CloseFont(font);
+}
+
+namespace
+{
+    std::mutex cache_lock;
+    std::map<std::pair<std::string, int>, std::unique_ptr<GlyphAtlas>> cache;
+}
+
+GlyphAtlas *GlyphAtlas::get(const std::string &font_path, int font_size)
+{
+    std::lock_guard<std::mutex> guard(cache_lock);
+    auto &atlas = cache[{font_path, font_size}];
+    if (!atlas)
+    {
+        TTF_Font *font = TTF_OpenFont(font_path.c_str(), font_size);
+        if (!font)
+        {
+            cache.erase({font_path, font_size});
+            return nullptr;
+        }
+        atlas = std::make_unique<GlyphAtlas>(font);
+    }
+    return atlas.get();
+}
+
+void GlyphAtlas::clear()
+{
+    std::lock_guard<std::mutex> guard(cache_lock);
+    cache.clear();
+}
+
+int GlyphAtlas::cellWidth() const
+{
+    return cell_width;
+}
+
+int GlyphAtlas::cellHeight() const
+{
+    return cell_height;
+}
+
+const unsigned char *GlyphAtlas::bitmap(unsigned char glyph)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    std::vector<unsigned char> &cell = bitmaps[glyph];
+    if (!cell.empty())
+    {
+        return cell.data();
+    }
+
+    cell.assign(static_cast<size_t>(cell_width) * cell_height, 0);
+    SDL_Surface *surface = nullptr;
+    if (glyph >= ' ' && glyph != 127)
+    {
+        SDL_Color white = {255, 255, 255, 255};
+        surface = TTF_RenderGlyph_Blended(font, glyph, white);
+    }
+    if (surface)
+    { // blended glyphs are ARGB8888, the coverage is in the alpha channel
+        int w = std::min(surface->w, cell_width), h = std::min(surface->h, cell_height);
+        for (int y = 0; y < h; ++y)
+        {
+            const Uint32 *row = reinterpret_cast<const Uint32 *>(static_cast<const Uint8 *>(surface->pixels) + y * surface->pitch);
+            for (int x = 0; x < w; ++x)
+            {
+                cell[y * cell_width + x] = row[x] >> 24;
+            }
+        }
+        SDL_FreeSurface(surface);
+    }
+    return cell.data();
+}
+
+SDL_Texture *GlyphAtlas::texture(SDL_Renderer *renderer, const std::string &text)
+{
+    if (!atlas_texture || atlas_renderer != renderer)
+    {
+        if (atlas_texture)
+        {
+            SDL_DestroyTexture(atlas_texture);
+        }
+        atlas_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STATIC,
+                                          ATLAS_COLUMNS * cell_width, (256 / ATLAS_COLUMNS) * cell_height);
+        atlas_renderer = renderer;
+        uploaded.fill(false);
+        if (!atlas_texture)
+        {
+            return nullptr;
+        }
+        SDL_SetTextureBlendMode(atlas_texture, SDL_BLENDMODE_BLEND);
+    }
+
+    std::array<bool, 256> used{};
+    for (unsigned char glyph : text)
+    {
+        used[glyph] = true;
+    }
+
+    std::vector<Uint32> pixels(static_cast<size_t>(cell_width) * cell_height);
+    for (int glyph = 0; glyph < 256; ++glyph)
+    {
+        if (!used[glyph] || uploaded[glyph] || glyph == '\n')
+        {
+            continue;
+        }
+        const unsigned char *coverage = bitmap(glyph);
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = (static_cast<Uint32>(coverage[i]) << 24) | 0x00FFFFFF;
+        }
+        SDL_Rect rect = glyphRect(glyph);
+        SDL_UpdateTexture(atlas_texture, &rect, pixels.data(), cell_width * 4);
+        uploaded[glyph] = true;
+    }
+    return atlas_texture;
+}
+
+SDL_Rect GlyphAtlas::glyphRect(unsigned char glyph) const
+{
+    return {(glyph % ATLAS_COLUMNS) * cell_width, (glyph / ATLAS_COLUMNS) * cell_height, cell_width, cell_height};
+}
@@ -0,0 +1,113 @@
+#ifndef ASCII_ART_GLYPHATLAS_HPP
+#define ASCII_ART_GLYPHATLAS_HPP
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+/**
+ * @brief Cache of rasterised glyphs of one font at one size
+ *
+ * @details Every glyph is rasterised only once (when it is needed for the first time) to a coverage bitmap of a single cell.
+ * The bitmaps are uploaded to one atlas texture, so an ascii image is rendered by copying the cells from the atlas
+ * instead of shaping and rasterising every line of the text.
+ * Atlases are shared by all images through GlyphAtlas::get, so the font is opened once per size.
+ */
+class GlyphAtlas
+{
+public:
+    /**
+     * @brief Construct a new GlyphAtlas, use GlyphAtlas::get to get a shared one
+     * @param font Opened font, the atlas takes the ownership
+     */
+    explicit GlyphAtlas(TTF_Font *font);
+
+    /**
+     * @brief Close the font and destroy the atlas texture
+     */
+    ~GlyphAtlas();
+
+    GlyphAtlas(const GlyphAtlas &) = delete;
+    GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+    /**
+     * @brief Get the shared atlas for the font and size, the font is opened on the first request
+     * @param font_path Path to the TTF font
+     * @param font_size Size of the font
+     * @return GlyphAtlas* the atlas owned by the cache (valid until GlyphAtlas::clear), nullptr if the font can't be opened
+     */
+    static GlyphAtlas *get(const std::string &font_path, int font_size);
+
+    /**
+     * @brief Drop all shared atlases (closes the fonts and destroys the textures), must be called before TTF_Quit
+     * and before destroying the renderer the textures were created with
+     */
+    static void clear();
+
+    /**
+     * @brief Get the width of the glyph cell (advance of the monospace font)
+     * @return int width of the cell in pixels
+     */
+    int cellWidth() const;
+
+    /**
+     * @brief Get the height of the glyph cell (height of the font)
+     * @return int height of the cell in pixels
+     */
+    int cellHeight() const;
+
+    /**
+     * @brief Get the coverage bitmap of the glyph (cellWidth() x cellHeight(), 0 - empty, 255 - fully covered), rasterise it if needed
+     * @param glyph The character
+     * @return const unsigned char* pointer to the bitmap
+     */
+    const unsigned char *bitmap(unsigned char glyph);
+
+    /**
+     * @brief Get the atlas texture containing (at least) all glyphs of the text
+     * @param renderer Renderer the texture is used with
+     * @param text Text which is going to be rendered
+     * @return SDL_Texture* the atlas texture (white glyphs, coverage in alpha), nullptr on failure
+     */
+    SDL_Texture *texture(SDL_Renderer *renderer, const std::string &text);
+
+    /**
+     * @brief Get the position of the glyph in the atlas texture
+     * @param glyph The character
+     * @return SDL_Rect the position of the glyph cell
+     */
+    SDL_Rect glyphRect(unsigned char glyph) const;
+
+private:
+    /**
+     * @brief Number of glyph cells in a row of the atlas texture (16 x 16 cells for all byte values)
+     */
+    static const int ATLAS_COLUMNS = 16;
+
+    TTF_Font *font;
+    int cell_width;
+    int cell_height;
+
+    /**
+     * @brief Coverage bitmaps of the glyphs, empty if the glyph was not rasterised yet
+     */
+    std::array<std::vector<unsigned char>, 256> bitmaps;
+
+    SDL_Renderer *atlas_renderer;
+    SDL_Texture *atlas_texture;
+
+    /**
+     * @brief Whether the glyph was uploaded to the atlas texture already
+     */
+    std::array<bool, 256> uploaded;
+
+    /**
+     * @brief Guards the font and the bitmaps, glyphs are rasterised from multiple threads
+     */
+    std::mutex lock;
+};
+
+#endif // ASCII_ART_GLYPHATLAS_HPP
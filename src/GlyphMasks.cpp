@@ -0,0 +1,109 @@
+#include "GlyphMasks.hpp"
+#include <algorithm>
+#include <array>
+#include <map>
+#include <mutex>
+
+GlyphMasks::GlyphMasks(const std::string &charset, GlyphAtlas &atlas)
+{
+    std::array<bool, 256> seen{};
+    const int width = atlas.cellWidth(), height = atlas.cellHeight();
+    for (char glyph : charset)
+    {
+        unsigned char code = glyph;
+        if (seen[code])
+        {
+            continue;
+        }
+        seen[code] = true;
+
+        const unsigned char *coverage = atlas.bitmap(code);
+        uint64_t mask = 0;
+        for (int row = 0; row < MASK_SIZE; ++row)
+        {
+            const int top = row * height / MASK_SIZE, bottom = std::max((row + 1) * height / MASK_SIZE, top + 1);
+            for (int column = 0; column < MASK_SIZE; ++column)
+            {
+                const int left = column * width / MASK_SIZE, right = std::max((column + 1) * width / MASK_SIZE, left + 1);
+                unsigned int sum = 0;
+                for (int y = top; y < bottom; ++y)
+                {
+                    for (int x = left; x < right; ++x)
+                    {
+                        sum += coverage[y * width + x];
+                    }
+                }
+                if (3 * sum >= 255u * (bottom - top) * (right - left))
+                {
+                    mask |= uint64_t(1) << bit(row, column);
+                }
+            }
+        }
+        glyphs.push_back(glyph);
+        masks.push_back(mask);
+    }
+}
+
+std::shared_ptr<const GlyphMasks> GlyphMasks::get(const std::string &charset)
+{
+    struct Cached
+    {
+        std::shared_ptr<const GlyphMasks> masks;
+        uint64_t last_used = 0;
+    };
+    static std::mutex lock;
+    static std::map<std::string, Cached> cache;
+    static uint64_t clock = 0;
+    static bool font_missing = false;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto cached = cache.find(charset);
+    if (cached != cache.end())
+    {
+        cached->second.last_used = ++clock;
+        return cached->second.masks;
+    }
+    if (font_missing)
+    {
+        return nullptr;
+    }
+
+    // the font is opened just for the rasterisation, the library stays initialised if somebody else uses it
+    if (TTF_Init() == -1)
+    {
+        return nullptr;
+    }
+    std::shared_ptr<const GlyphMasks> masks;
+    if (TTF_Font *font = TTF_OpenFont(FONT_PATH, RASTER_FONT_SIZE))
+    {
+        GlyphAtlas atlas(font);
+        masks = std::make_shared<const GlyphMasks>(charset, atlas);
+        if (cache.size() >= MAX_CACHED)
+        { // the images still using the dropped masks keep them alive
+            cache.erase(std::min_element(cache.begin(), cache.end(), [](const auto &a, const auto &b)
+                                         { return a.second.last_used < b.second.last_used; }));
+        }
+        cache.emplace(charset, Cached{masks, ++clock});
+    }
+    else
+    {
+        font_missing = true;
+    }
+    TTF_Quit();
+    return masks;
+}
+
+size_t GlyphMasks::size() const
+{
+    return glyphs.size();
+}
+
+char GlyphMasks::glyph(size_t index) const
+{
+    return glyphs[index];
+}
+
+uint64_t GlyphMasks::mask(size_t index) const
+{
+    return masks[index];
+}
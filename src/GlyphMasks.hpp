@@ -0,0 +1,93 @@
+#ifndef ASCII_ART_GLYPHMASKS_HPP
+#define ASCII_ART_GLYPHMASKS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GlyphAtlas.hpp"
+
+/**
+ * @brief Shapes of the glyphs of a charset as bit masks, used to match the glyphs to the structure of the cells
+ *
+ * @details Every glyph is rasterised with the font of the image output and downsampled to MASK_SIZE x MASK_SIZE
+ * blocks of its cell, a block is set if the glyph covers at least a third of it. The 64 blocks are packed to one
+ * 64-bit word (row by row, the top left block is the lowest bit), so two shapes are compared by a single popcount
+ * of their xor (the Hamming distance).
+ * Masks are immutable and built once per charset (GlyphMasks::get), they are shared by all images and threads.
+ * At most MAX_CACHED charsets are kept, the least recently used one is rasterised again when it is needed.
+ */
+class GlyphMasks
+{
+public:
+    /**
+     * @brief Number of the blocks of a mask in a row and in a column
+     */
+    static constexpr int MASK_SIZE = 8;
+
+    /**
+     * @brief Path to the font the glyphs are rasterised with, the same as the one of the image output
+     */
+    static constexpr const char *FONT_PATH = "assets/CourierPrime.ttf";
+
+    /**
+     * @brief Number of the charsets whose masks are kept by get
+     */
+    static constexpr size_t MAX_CACHED = 16;
+
+    /**
+     * @brief Rasterise the distinct glyphs of the charset
+     * @param charset The charset (density) used for the ascii image
+     * @param atlas Glyphs of the font
+     */
+    GlyphMasks(const std::string &charset, GlyphAtlas &atlas);
+
+    /**
+     * @brief Get the shared masks of the charset, the glyphs are rasterised only on the first request
+     * @param charset The charset (density) used for the ascii image
+     * @return std::shared_ptr<const GlyphMasks> the masks, nullptr if the font can't be opened
+     */
+    static std::shared_ptr<const GlyphMasks> get(const std::string &charset);
+
+    /**
+     * @brief Get the number of the distinct glyphs of the charset
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the glyph, the glyphs are in the order of their first occurrence in the charset
+     */
+    char glyph(size_t index) const;
+
+    /**
+     * @brief Get the mask of the glyph
+     */
+    uint64_t mask(size_t index) const;
+
+    /**
+     * @brief Get the index of the bit of the block in the row and the column of the mask
+     */
+    static int bit(int row, int column)
+    {
+        return row * MASK_SIZE + column;
+    }
+
+    /**
+     * @brief Count the set bits, the distance of two masks is the popcount of their xor
+     */
+    static int popcount(uint64_t mask)
+    {
+        return __builtin_popcountll(mask);
+    }
+
+private:
+    /**
+     * @brief Size of the font the glyphs are rasterised at, big enough for the thin strokes to cover their blocks
+     */
+    static const int RASTER_FONT_SIZE = 48;
+
+    std::vector<char> glyphs;
+    std::vector<uint64_t> masks;
+};
+
+#endif // ASCII_ART_GLYPHMASKS_HPP
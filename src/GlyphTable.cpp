@@ -0,0 +1,97 @@
+#include "GlyphTable.hpp"
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+GlyphTable::GlyphTable(const std::string &charset, double brightness)
+{
+    if (charset.empty())
+    {
+        glyphs.fill(' ');
+        return;
+    }
+
+    if (brightness < 0)
+    {
+        brightness = 0;
+    }
+
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        double gray_level = pow(gray / 255.0, brightness);
+        int idx = (double)(gray_level * (charset.length() - 1));
+        glyphs[gray] = charset[idx];
+    }
+}
+
+GlyphTable::GlyphTable(const GlyphTable &table, const ToneCurve &curve)
+{
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        glyphs[gray] = table[curve[gray]];
+    }
+}
+
+std::shared_ptr<const GlyphTable> GlyphTable::get(const std::string &charset, double brightness)
+{
+    struct Cached
+    {
+        std::shared_ptr<const GlyphTable> table;
+        uint64_t last_used = 0;
+    };
+    static std::mutex lock;
+    static std::map<std::string, std::map<double, Cached>> tables;
+    static size_t count = 0;
+    static uint64_t clock = 0;
+
+    std::lock_guard<std::mutex> guard(lock);
+    // looked up first, so a cached table is found without copying the charset
+    auto charset_tables = tables.find(charset);
+    if (charset_tables != tables.end())
+    {
+        auto cached = charset_tables->second.find(brightness);
+        if (cached != charset_tables->second.end())
+        {
+            cached->second.last_used = ++clock;
+            return cached->second.table;
+        }
+    }
+
+    if (count >= MAX_CACHED)
+    { // the images still using the dropped table keep it alive
+        auto oldest_charset = tables.begin();
+        auto oldest = oldest_charset->second.begin();
+        for (auto it = tables.begin(); it != tables.end(); ++it)
+        {
+            for (auto table = it->second.begin(); table != it->second.end(); ++table)
+            {
+                if (table->second.last_used < oldest->second.last_used)
+                {
+                    oldest_charset = it;
+                    oldest = table;
+                }
+            }
+        }
+        oldest_charset->second.erase(oldest);
+        if (oldest_charset->second.empty())
+        {
+            if (oldest_charset == charset_tables)
+            {
+                charset_tables = tables.end();
+            }
+            tables.erase(oldest_charset);
+        }
+        --count;
+    }
+
+    if (charset_tables == tables.end())
+    {
+        charset_tables = tables.emplace(charset, std::map<double, Cached>()).first;
+    }
+    Cached &cached = charset_tables->second[brightness];
+    cached.table = std::make_shared<GlyphTable>(charset, brightness);
+    cached.last_used = ++clock;
+    ++count;
+    return cached.table;
+}
@@ -0,0 +1,62 @@
+#ifndef ASCII_ART_GLYPHTABLE_HPP
+#define ASCII_ART_GLYPHTABLE_HPP
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "ToneCurve.hpp"
+
+/**
+ * @brief Lookup table mapping every gray level (0-255) to a glyph of the charset
+ *
+ * @details The brightness curve pow(gray / 255, brightness) is evaluated only 256 times when the table is built,
+ * the conversion itself is then a single lookup per output cell.
+ * Tables are immutable, so one table can be shared by all images (and threads) with the same charset and brightness.
+ * At most MAX_CACHED tables are kept, a long running server would otherwise keep every charset and brightness it was asked for.
+ */
+class GlyphTable
+{
+public:
+    /**
+     * @brief Build the table
+     * @param charset The charset (density) used for the ascii image
+     * @param brightness The brightness applied to the image, negative values are treated as 0
+     */
+    GlyphTable(const std::string &charset, double brightness);
+
+    /**
+     * @brief Build the table of the gray levels before the tone curve, the curve is looked up together with the glyph
+     * @param table The table of the gray levels after the curve
+     * @param curve The tone curve of the image
+     */
+    GlyphTable(const GlyphTable &table, const ToneCurve &curve);
+
+    /**
+     * @brief Number of the tables kept by get, the least recently used one is dropped when another one is built
+     */
+    static constexpr size_t MAX_CACHED = 64;
+
+    /**
+     * @brief Get a shared table for the charset and brightness, the table is built only on the first request
+     * @param charset The charset (density) used for the ascii image
+     * @param brightness The brightness applied to the image
+     * @return std::shared_ptr<const GlyphTable> the table
+     */
+    static std::shared_ptr<const GlyphTable> get(const std::string &charset, double brightness);
+
+    /**
+     * @brief Get the glyph for the gray level
+     * @param gray The gray level of the pixel
+     * @return char the glyph
+     */
+    char operator[](unsigned char gray) const
+    {
+        return glyphs[gray];
+    }
+
+private:
+    std::array<char, 256> glyphs;
+};
+
+#endif // ASCII_ART_GLYPHTABLE_HPP
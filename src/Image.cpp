@@ -1,77 +1,254 @@
 #include "Image.hpp"
-#include <cmath>
+#include "AsciiConverter.hpp"
+#include "BufferPool.hpp"
+#include "Convolution.hpp"
+#include "ImageJPG.hpp"
+#include "ImagePNG.hpp"
+#include "Trace.hpp"
 #include <cstdio>
 #include <iostream>
-#include <sstream>
 #include <algorithm>
+#include <optional>
+#include <tuple>
 
-void Image::imgToAscii(const double scaleFactor, const std::string charset, double brightness)
+Image::~Image()
 {
-    int scaledWidth = width * scaleFactor;
-    int scaledHeight = height * scaleFactor;
+    releasePixels();
+}
+
+std::unique_ptr<Image> Image::create(const ImageSource &source)
+{
+    switch (source.format())
+    {
+    case ImageSource::Format::PNG:
+        return std::make_unique<ImagePNG>();
+    case ImageSource::Format::JPEG:
+        return std::make_unique<ImageJPG>();
+    default:
+        return nullptr;
+    }
+}
+
+bool Image::load(const std::string &filename, bool inverted, double scale, bool color)
+{
+    std::unique_ptr<ImageSource> source = ImageSource::open(filename);
+    return source && load(*source, inverted, scale, color);
+}
+
+bool Image::load(const ImageSource &source, bool inverted, double scale, bool color)
+{
+    return decode(source, inverted, scale, color, [this, color](const unsigned char *row, const unsigned char *rgb, unsigned int y)
+                  {
+        const size_t offset = static_cast<size_t>(y) * width;
+        if (y == 0)
+        {
+            releasePixels();
+            const size_t size = static_cast<size_t>(width) * height;
+            data = BufferPool<unsigned char>::shared().acquire(size);
+            if (color)
+            {
+                color_data.red = BufferPool<unsigned char>::shared().acquire(size);
+                color_data.green = BufferPool<unsigned char>::shared().acquire(size);
+                color_data.blue = BufferPool<unsigned char>::shared().acquire(size);
+            }
+        }
+        std::copy(row, row + width, data.begin() + offset);
+        if (rgb)
+        { // split to the planes
+            unsigned char *red = &color_data.red[offset], *green = &color_data.green[offset], *blue = &color_data.blue[offset];
+            for (unsigned int x = 0; x < width; ++x)
+            {
+                red[x] = rgb[x * 3];
+                green[x] = rgb[x * 3 + 1];
+                blue[x] = rgb[x * 3 + 2];
+            }
+        } });
+}
+
+bool Image::loadAscii(const Img &img)
+{
+    std::unique_ptr<ImageSource> source = ImageSource::open(img.image_path);
+    return source && loadAscii(*source, img);
+}
+
+bool Image::loadAscii(const ImageSource &source, const Img &img)
+{
+    Trace::Span span("Image::loadAscii", img.image_path, img.scale);
+
+    // the callback captures just two pointers, so it fits into std::function without allocating
+    struct Streaming
+    {
+        const Img &img;
+        std::optional<ToneCurve> tone;
+        std::optional<Transform> transform;
+        std::optional<AsciiConverter> converter;
+    } streaming{img, std::nullopt, std::nullopt, std::nullopt};
+    if (!img.tone.empty())
+    {
+        streaming.tone.emplace(img.tone);
+    }
 
+    bool loaded = decode(source, img.invert, img.scale, false, [this, &streaming](const unsigned char *row, const unsigned char *, unsigned int y)
+                         {
+        const Img &options = streaming.img;
+        if (!streaming.converter)
+        { // the decoder already knows the size of the image
+            streaming.transform.emplace(width, height, options, options.scale / decoded_scale);
+            streaming.converter.emplace(*streaming.transform, *options.charset, options.brightness, ascii_image, streaming.tone ? &*streaming.tone : nullptr);
+        }
+        while (streaming.converter->nextRow() == static_cast<int>(y))
+        {
+            streaming.converter->convertRow(row);
+        } });
+
+    if (!loaded || !streaming.converter || streaming.converter->nextRow() != -1)
+    {
+        return false;
+    }
+    ascii_width = streaming.transform->columns();
+    ascii_height = streaming.transform->lines();
+    span.setSize(width, height);
+    return true;
+}
+
+void Image::imgToAscii(const Img &img)
+{
+    Trace::Span span("Image::imgToAscii", img.image_path, img.scale);
+    span.setSize(width, height);
     if (data.size() < width * height)
     {
         std::cout << "Error while converting image to ascii art." << std::endl;
         return;
     }
 
-    for (int y = 0; y < scaledHeight; ++y)
+    // the loader may have already applied part of the scale while decoding
+    Transform transform(width, height, img, img.scale / decoded_scale);
+    // the tone operations before the last filter are applied with the filters, the later ones are fused with the glyphs
+    const size_t filtered_tone = img.filters.empty() ? 0 : std::min(img.filters.back().tone_before, img.tone.size());
+    std::optional<ToneCurve> tone;
+    if (filtered_tone < img.tone.size())
     {
-        for (int x = 0; x < scaledWidth; ++x)
-        {
-            int scaledX = x / scaleFactor;
-            int scaledY = y / scaleFactor;
-            int index = scaledY * width + scaledX;
-            auto pixel = data[index];
+        tone.emplace(img.tone.begin() + filtered_tone, img.tone.end());
+    }
+    AsciiConverter converter(transform, *img.charset, img.brightness, ascii_image, tone ? &*tone : nullptr, img.cells);
 
-            if (brightness < 0)
-            {
-                brightness = 0;
-            }
+    // the filtered pixels are converted, the loaded ones are kept
+    const unsigned char *pixels = data.data();
+    PooledBuffer<unsigned char> filtered;
+    if (!img.filters.empty())
+    {
+        filtered.resize(static_cast<size_t>(width) * height);
+        Convolution::apply(img.filters, img.tone, decoded_scale, data.data(), width, height, filtered.data());
+        pixels = filtered.data();
+    }
+    const bool colored = img.color != ColorMode::None && color_data.red.size() >= data.size();
+    // the samples of the cells are thresholded to the dots, the shapes of the glyphs don't matter
+    std::shared_ptr<const GlyphMasks> masks;
+    if (img.cells == CellMode::Charset && img.sampling == Sampling::Shape && !(masks = GlyphMasks::get(*img.charset)))
+    { // the area sampling below is used instead
+        std::cout << "Font " << GlyphMasks::FONT_PATH << " can't be opened, the glyphs are chosen by the area sampling." << std::endl;
+    }
+    if (img.cells != CellMode::Charset)
+    {
+        converter.convertImageCells(pixels, height, img.sampling != Sampling::Nearest, colored, img.dither);
+    }
+    else if (masks)
+    {
+        converter.convertImageShapes(pixels, height, *masks);
+    }
+    else if (img.dither != Dithering::None)
+    {
+        converter.convertImageDithered(pixels, height, img.sampling != Sampling::Nearest, img.dither);
+    }
+    else if (img.sampling != Sampling::Nearest)
+    {
+        converter.convertImageArea(pixels, height);
+    }
+    else
+    {
+        converter.convertImage(pixels);
+    }
+    ascii_width = converter.columns();
+    ascii_height = converter.lines();
 
-            double gray_level = pow(pixel / 255.0, brightness);
-            int idx = (double)(gray_level * (charset.length() - 1));
-            ascii_image += charset[idx];
+    ascii_colors = ColorPlanes();
+    ascii_backgrounds = ColorPlanes();
+    if (!colored)
+    {
+        return;
+    }
+    // the same pixels as the glyphs of the cells are taken (or averaged)
+    const size_t cells = static_cast<size_t>(ascii_width) * ascii_height;
+    const std::tuple<const std::vector<unsigned char> *, std::vector<unsigned char> *, std::vector<unsigned char> *> planes[] = {
+        {&color_data.red, &ascii_colors.red, &ascii_backgrounds.red},
+        {&color_data.green, &ascii_colors.green, &ascii_backgrounds.green},
+        {&color_data.blue, &ascii_colors.blue, &ascii_backgrounds.blue}};
+    for (const auto &[source, colors, backgrounds] : planes)
+    {
+        colors->resize(cells);
+        if (img.cells != CellMode::Charset)
+        {
+            const bool halves = img.cells == CellMode::HalfBlock;
+            backgrounds->resize(halves ? cells : 0);
+            converter.cellColors(source->data(), height, img.sampling != Sampling::Nearest, colors->data(), halves ? backgrounds->data() : nullptr);
+        }
+        else if (img.sampling != Sampling::Nearest)
+        {
+            converter.averageCells(source->data(), height, colors->data());
+        }
+        else
+        {
+            converter.sampleCells(source->data(), colors->data());
         }
-        ascii_image += '\n';
     }
 }
 
-SDL_Texture *Image::createTexture(SDL_Renderer *renderer, TTF_Font *font, int font_size, double scale) const
+SDL_Texture *Image::createTexture(SDL_Renderer *renderer, GlyphAtlas &atlas, int font_size) const
 {
-    SDL_Color textColor = {255, 255, 255, 255};
-
-    int full_width = width * font_size * scale;
-    int full_height = height * font_size * scale;
+    Trace::Span span("Image::createTexture");
+    int full_width = ascii_width * font_size;
+    int full_height = ascii_height * font_size;
 
-    std::vector<SDL_Surface *> surfaces;
-    const char *text = ascii_image.c_str();
-    std::stringstream ss(text);
-    std::string line;
-    while (std::getline(ss, line))
+    SDL_Texture *glyphs = atlas.texture(renderer, ascii_image);
+    if (!glyphs)
     {
-        SDL_Surface *surface = TTF_RenderText_Blended(font, line.c_str(), textColor);
-        surfaces.push_back(surface);
+        return nullptr;
     }
 
     SDL_Texture *full_image = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGB24, SDL_TEXTUREACCESS_TARGET, full_width, full_height);
+    if (!full_image)
+    {
+        return nullptr;
+    }
 
     SDL_SetRenderTarget(renderer, full_image);
     SDL_SetTextureBlendMode(full_image, SDL_BLENDMODE_BLEND);
     SDL_RenderClear(renderer);
 
-    int i = 0;
-    double multiply_factor = (double)full_width / surfaces[0]->w;
-    for (SDL_Surface *surface : surfaces)
+    // glyphs of the monospace font are stretched to square cells of font_size, as the whole lines used to be
+    const char *cell = ascii_image.data();
+    for (unsigned int y = 0; y < ascii_height; ++y, ++cell)
     {
-        SDL_Texture *lineTexture = SDL_CreateTextureFromSurface(renderer, surface);
-        SDL_Rect dstRect = {0, i * font_size, static_cast<int>(surface->w * multiply_factor), surface->h};
-        i++;
-
-        SDL_RenderCopy(renderer, lineTexture, NULL, &dstRect);
-        SDL_FreeSurface(surface);
+        for (unsigned int x = 0; x < ascii_width; ++x, ++cell)
+        {
+            if (*cell == ' ')
+            {
+                continue;
+            }
+            SDL_Rect srcRect = atlas.glyphRect(*cell);
+            SDL_Rect dstRect = {static_cast<int>(x) * font_size, static_cast<int>(y) * font_size, font_size, atlas.cellHeight()};
+            SDL_RenderCopy(renderer, glyphs, &srcRect, &dstRect);
+        }
     }
 
     return full_image;
-}
\ No newline at end of file
+}
+
+void Image::releasePixels()
+{
+    for (std::vector<unsigned char> *plane : {&data, &color_data.red, &color_data.green, &color_data.blue})
+    {
+        BufferPool<unsigned char>::shared().release(std::move(*plane));
+        plane->clear();
+    }
+}
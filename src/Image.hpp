@@ -1,64 +1,170 @@
 #ifndef ASCII_ART_IMAGE_HPP
 #define ASCII_ART_IMAGE_HPP
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
+#include "GlyphAtlas.hpp"
+#include "ImageSource.hpp"
+#include "ImgOptions.hpp"
 
 /**
  * @brief "Abstract" base class for different image types (png, jpg, ...)
  *
  * @details This class is used to load the image from the given path, convert it to ascii and optionally create a texture from it.
- * Derived classes are ImagePNG and ImageJPG and they must implement the load method.
+ * Derived classes are ImagePNG and ImageJPG and they must implement the decode method, which reads the encoded image from an ImageSource.
+ * The image can be either loaded to memory (load) or streamed row by row straight to the ascii image (loadAscii).
  */
 class Image
 {
 public:
-    Image(unsigned int width, unsigned int height) : width(width), height(height)
+    Image(unsigned int width, unsigned int height) : width(width), height(height), decoded_scale(1.0), ascii_width(0), ascii_height(0)
     {
         ascii_image = "";
     }
-    virtual ~Image() = default;
+    /**
+     * @brief Destroy the image, the pixels are returned to the buffer pool
+     */
+    virtual ~Image();
+
+    /**
+     * @brief Create the image object for the format detected from the magic bytes of the source
+     * @param source The bytes of the encoded image
+     * @return std::unique_ptr<Image> ImagePNG or ImageJPG, nullptr if the format is not supported
+     */
+    static std::unique_ptr<Image> create(const ImageSource &source);
+
+    /**
+     * @brief Callback receiving the decoded gray rows (width pixels each) from top to bottom together with the row index,
+     * rgb is the same row with interleaved colours (3 bytes per pixel) if the colours were requested, nullptr otherwise
+     */
+    using RowCallback = std::function<void(const unsigned char *row, const unsigned char *rgb, unsigned int y)>;
+
+    /**
+     * @brief Planes of the red, green and blue channel (structure of arrays), the layout is the same as of the gray plane
+     */
+    struct ColorPlanes
+    {
+        std::vector<unsigned char> red;
+        std::vector<unsigned char> green;
+        std::vector<unsigned char> blue;
+    };
 
     /**
-     * @brief Pure virtual method for loading the image from given path and saving the pixels to the data vector
+     * @brief Load the image from given path and save the pixels to the data vector
      * @param filename The path to the image
      * @param inverted Whether to invert the image or not
+     * @param scale The scale the image will be converted with, loaders may use it to decode a smaller image (see decoded_scale)
+     * @param color Whether to keep the colours of the pixels in color_data as well
      * @return true if the image was loaded successfully
      */
-    virtual bool load(const std::string &filename, bool inverted) = 0;
+    bool load(const std::string &filename, bool inverted, double scale, bool color = false);
 
     /**
-     * @brief Convert the image to ascii and save it to the ascii_image string
-     * @param scaleFactor The scale factor to apply to the image
-     * @param charset The charset (density) to use for the ascii image
-     * @param brightness The brightness to apply to the image
+     * @brief Load the image from the source and save the pixels to the data vector
+     * @param source The bytes of the encoded image
+     * @param inverted Whether to invert the image or not
+     * @param scale The scale the image will be converted with, loaders may use it to decode a smaller image (see decoded_scale)
+     * @param color Whether to keep the colours of the pixels in color_data as well
+     * @return true if the image was loaded successfully
+     */
+    bool load(const ImageSource &source, bool inverted, double scale, bool color = false);
+
+    /**
+     * @brief Decode the image from given path and convert it to ascii row by row without keeping the pixels in memory.
+     * Only images whose transform is row local (see Transform::isRowLocal) can be converted this way, the filters are not applied.
+     * @param img Configuration of the image (path, invert, scale, charset, brightness, tone, rotation and flips)
+     * @return true if the image was loaded and converted successfully
+     */
+    bool loadAscii(const Img &img);
+
+    /**
+     * @brief Decode the image from the source and convert it to ascii row by row, see loadAscii(const Img &)
+     * @param source The bytes of the encoded image
+     * @param img Configuration of the image (invert, scale, charset, brightness, tone, rotation and flips)
+     * @return true if the image was loaded and converted successfully
+     */
+    bool loadAscii(const ImageSource &source, const Img &img);
+
+    /**
+     * @brief Convert the loaded image to ascii and save it to the ascii_image string,
+     * the colours of the cells are saved to ascii_colors if the image was loaded with colours and img.color is set
+     * @param img Configuration of the image (scale, charset, brightness, tone, filters, rotation, flips, sampling and colour)
      */
-    void imgToAscii(const double scaleFactor, const std::string charset, double brightness);
+    void imgToAscii(const Img &img);
 
     /**
      * @brief Create a texture from the ascii image which can be rendered to the screen or saved to a png file
      * @param renderer Pointer to the SDL_Renderer object which will be used to create the SDL_Texture
-     * @param font Pointer to the TTF_Font object used for rendering text to the texture
+     * @param atlas Glyphs of the font the text is rendered with, the cells are copied from its atlas texture
      * @param font_size Size of the font used for rendering text to the texture
-     * @param scale The scaling factor to apply to the texture
      * @return SDL_Texture* Newly created SDL_Texture object from the ascii string
      */
-    SDL_Texture *createTexture(SDL_Renderer *renderer, TTF_Font *font, int font_size, double scale) const;
+    SDL_Texture *createTexture(SDL_Renderer *renderer, GlyphAtlas &atlas, int font_size) const;
+
+    /**
+     * @brief Return the pixels to the buffer pool (see BufferPool), only the ascii image is kept
+     */
+    void releasePixels();
 
     unsigned int width;
     unsigned int height;
 
     /**
-     * @brief The data of the image (pixels)
+     * @brief Size of the decoded image relative to the image file (1.0 unless the loader decoded a reduced image)
+     */
+    double decoded_scale;
+
+    /**
+     * @brief Number of columns (cells per line) of the ascii image
+     */
+    unsigned int ascii_width;
+
+    /**
+     * @brief Number of lines of the ascii image
+     */
+    unsigned int ascii_height;
+
+    /**
+     * @brief The data of the image (pixels), drawn from the buffer pool
      */
     std::vector<unsigned char> data;
 
     /**
-     * @brief The ascii image stored as a string
+     * @brief Colours of the pixels next to the gray data, empty unless the image was loaded with colours
+     */
+    ColorPlanes color_data;
+
+    /**
+     * @brief The ascii image stored as a string, UTF-8 for the braille and half block cells
      */
     std::string ascii_image;
+
+    /**
+     * @brief Colours of the cells of the ascii image (ascii_width * ascii_height each, without the line ends),
+     * empty unless colours were requested
+     */
+    ColorPlanes ascii_colors;
+
+    /**
+     * @brief Background colours of the half block cells (the lower halves), empty for the other cells
+     */
+    ColorPlanes ascii_backgrounds;
+
+protected:
+    /**
+     * @brief Pure virtual method for decoding the image from the source.
+     * Implementations set width, height and decoded_scale before the first row is passed to the callback.
+     * @param source The bytes of the encoded image
+     * @param inverted Whether to invert the image or not
+     * @param scale The scale the image will be converted with, the decoder may use it to decode a smaller image
+     * @param color Whether to pass the colours of the rows to the callback as well
+     * @param row_callback Callback receiving the decoded gray (and colour) rows
+     * @return true if the image was decoded successfully
+     */
+    virtual bool decode(const ImageSource &source, bool inverted, double scale, bool color, const RowCallback &row_callback) = 0;
 };
 
 #endif // ASCII_ART_IMAGE_HPP
@@ -1,7 +1,10 @@
 #include "ImageJPG.hpp"
 #include <jpeglib.h>
+#include <cmath>
 #include <iostream>
 #include <setjmp.h>
+#include "BufferPool.hpp"
+#include "Trace.hpp"
 
 /**
  * @brief Structure for custom error handling in libjpeg
@@ -39,17 +42,47 @@ void err_exit(j_common_ptr cinfo) {
 }
 
 
-bool ImageJPG::load(const std::string &filename, bool inverted)
+namespace
 {
-
-    FILE *file = fopen(filename.c_str(), "rb");
-    if (!file)
+    unsigned char clamp(int value)
     {
-        return false;
+        return value < 0 ? 0 : (value > 255 ? 255 : value);
     }
 
+    /**
+     * @brief Tables of the YCbCr -> RGB conversion (JFIF), computed once like in libjpeg
+     */
+    struct YCbCrTables
+    {
+        YCbCrTables()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                int c = i - 128;
+                cr_r[i] = static_cast<int>(std::lround(1.402 * c));
+                cb_b[i] = static_cast<int>(std::lround(1.772 * c));
+                cr_g[i] = static_cast<int>(std::lround(-0.714136 * c));
+                cb_g[i] = static_cast<int>(std::lround(-0.344136 * c));
+            }
+        }
+
+        int cr_r[256];
+        int cb_b[256];
+        int cr_g[256];
+        int cb_g[256];
+    };
+}
+
+bool ImageJPG::decode(const ImageSource &source, bool inverted, double scale, bool color, const RowCallback &row_callback)
+{
+    Trace::Span span("ImageJPG::decode", source.name(), scale);
+    static const YCbCrTables tables;
+
     jpeg_decompress_struct cinfo;
     my_error_mgr jerr;
+    PooledBuffer<unsigned char> scanline;
+    PooledBuffer<unsigned char> row;
+    PooledBuffer<unsigned char> rgb;
 
     cinfo.err = jpeg_std_error(&jerr.pub);
     jerr.pub.error_exit = err_exit;
@@ -57,45 +90,95 @@ bool ImageJPG::load(const std::string &filename, bool inverted)
     if (setjmp(jerr.setjmp_buffer))
     {
         jpeg_destroy_decompress(&cinfo);
-        fclose(file);
         return false;
     }
 
     jpeg_create_decompress(&cinfo);
-    jpeg_stdio_src(&cinfo, file);
+    // older libjpeg versions take a non-const buffer, it is only read anyway
+    jpeg_mem_src(&cinfo, const_cast<unsigned char *>(source.data()), source.size());
 
     if (jpeg_read_header(&cinfo, TRUE) != JPEG_HEADER_OK)
     {
         jpeg_destroy_decompress(&cinfo);
-        fclose(file);
         return false;
     }
 
+    // For colours, YCbCr images are decoded without the colour conversion, the luma is then exactly the grayscale output
+    // and the RGB is computed from it. Other colour spaces are decoded to RGB and the luma is computed the way libjpeg does it.
     cinfo.out_color_space = JCS_GRAYSCALE;
+    if (color && cinfo.jpeg_color_space != JCS_GRAYSCALE)
+    {
+        cinfo.out_color_space = cinfo.jpeg_color_space == JCS_YCbCr ? JCS_YCbCr : JCS_RGB;
+    }
+
+    // The image is downscaled anyway, let the IDCT decode it at 1/2, 1/4 or 1/8 size (the smallest one still at least as big as the output)
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = 1;
+    while (cinfo.scale_denom < 8 && scale * cinfo.scale_denom * 2 <= 1.0)
+    {
+        cinfo.scale_denom *= 2;
+    }
     jpeg_start_decompress(&cinfo);
 
     width = cinfo.output_width;
     height = cinfo.output_height;
+    decoded_scale = (double)cinfo.output_width / cinfo.image_width;
+    span.setSize(width, height);
 
-    data.resize(width * height);
+    const int components = cinfo.output_components;
+    scanline.resize(static_cast<size_t>(width) * components);
+    row.resize(width);
+    if (color)
+    {
+        rgb.resize(static_cast<size_t>(width) * 3);
+    }
     while (cinfo.output_scanline < cinfo.output_height)
     {
+        unsigned int y = cinfo.output_scanline;
         unsigned char *buffer[1];
-        buffer[0] = data.data() + cinfo.output_scanline * width;
+        buffer[0] = components == 1 ? row.data() : scanline.data();
 
         jpeg_read_scanlines(&cinfo, buffer, 1);
+        for (unsigned int i = 0; color && i < width; ++i)
+        {
+            const unsigned char *pixel = buffer[0] + i * components;
+            unsigned char *out = &rgb[i * 3];
+            if (components == 1)
+            {
+                out[0] = out[1] = out[2] = pixel[0];
+            }
+            else if (cinfo.out_color_space == JCS_YCbCr)
+            {
+                int luma = pixel[0];
+                row[i] = pixel[0];
+                out[0] = clamp(luma + tables.cr_r[pixel[2]]);
+                out[1] = clamp(luma + tables.cb_g[pixel[1]] + tables.cr_g[pixel[2]]);
+                out[2] = clamp(luma + tables.cb_b[pixel[1]]);
+            }
+            else
+            {
+                out[0] = pixel[0];
+                out[1] = pixel[1];
+                out[2] = pixel[2];
+                row[i] = (19595 * pixel[0] + 38470 * pixel[1] + 7471 * pixel[2] + 32768) >> 16;
+            }
+        }
         if (inverted)
         {
             for (unsigned int i = 0; i < width; ++i)
             {
-                buffer[0][i] = 255 - buffer[0][i];
+                row[i] = 255 - row[i];
+            }
+            for (size_t i = 0; color && i < static_cast<size_t>(width) * 3; ++i)
+            {
+                rgb[i] = 255 - rgb[i];
             }
         }
+        row_callback(row.data(), color ? rgb.data() : nullptr, y);
     }
 
     jpeg_finish_decompress(&cinfo);
     jpeg_destroy_decompress(&cinfo);
-    fclose(file);
 
     return true;
 }
\ No newline at end of file
@@ -9,7 +9,9 @@ class ImageJPG : public Image
 {
 public:
     ImageJPG(int width = 0, int height = 0) : Image(width, height) {}
-    bool load(const std::string &filename, bool inverted) override;
+
+protected:
+    bool decode(const ImageSource &source, bool inverted, double scale, bool color, const RowCallback &row_callback) override;
 };
 
 #endif // ASCII_ART_IMAGEJPG_HPP
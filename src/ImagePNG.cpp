@@ -1,42 +1,72 @@
 #include "ImagePNG.hpp"
 #include "png.h"
+#include "BufferPool.hpp"
+#include "Trace.hpp"
+#include <cstring>
 
-bool ImagePNG::load(const std::string &filename, bool inverted)
+namespace
 {
-
-    FILE *file = fopen(filename.c_str(), "rb");
-    if (!file)
+    /**
+     * @brief Position of libpng in the bytes of the source
+     */
+    struct MemoryReader
     {
-        return false;
+        const unsigned char *data;
+        size_t size;
+        size_t position;
+    };
+
+    /**
+     * @brief Custom read function of libpng copying the bytes from the memory of the source
+     */
+    void readMemory(png_structp png, png_bytep out, png_size_t length)
+    {
+        MemoryReader *reader = static_cast<MemoryReader *>(png_get_io_ptr(png));
+        if (length > reader->size - reader->position)
+        {
+            png_error(png, "Unexpected end of the image.");
+        }
+        std::memcpy(out, reader->data + reader->position, length);
+        reader->position += length;
     }
+}
+
+bool ImagePNG::decode(const ImageSource &source, bool inverted, double scale, bool color, const RowCallback &row_callback)
+{
+    Trace::Span span("ImagePNG::decode", source.name(), scale);
+    MemoryReader reader = {source.data(), source.size(), 0};
 
     png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
     if (!png)
     {
-        fclose(file);
         return false;
     }
 
+    // declared before setjmp, so they are destroyed when libpng jumps back with an error
+    PooledBuffer<png_byte> rgba;
+    PooledBuffer<png_bytep> row_pointers;
+    PooledBuffer<unsigned char> gray;
+    PooledBuffer<unsigned char> rgb;
+
     png_infop info = png_create_info_struct(png);
     if (!info)
     {
         png_destroy_read_struct(&png, nullptr, nullptr);
-        fclose(file);
         return false;
     }
 
     if (setjmp(png_jmpbuf(png)))
     { // Error handling
         png_destroy_read_struct(&png, &info, nullptr);
-        fclose(file);
         return false;
     }
 
-    png_init_io(png, file);
+    png_set_read_fn(png, &reader, readMemory);
     png_read_info(png, info);
 
     width = png_get_image_width(png, info);
     height = png_get_image_height(png, info);
+    span.setSize(width, height);
 
     int color_type = png_get_color_type(png, info);
 
@@ -70,42 +100,71 @@ bool ImagePNG::load(const std::string &filename, bool inverted)
         png_set_scale_16(png);
     }
 
+    int passes = png_set_interlace_handling(png);
     png_read_update_info(png, info);
 
-    std::vector<png_bytep> row_pointers(height);
-    std::vector<png_byte> row(height * width * 4);
-    for (unsigned int i = 0; i < height; ++i)
+    // interlaced image is complete only after the last pass, so it has to be read whole, otherwise a single row is enough
+    size_t rows_in_memory = passes > 1 ? height : 1;
+    rgba.resize(rows_in_memory * width * 4);
+    row_pointers.resize(rows_in_memory);
+    for (size_t i = 0; i < rows_in_memory; ++i)
+    {
+        row_pointers[i] = &rgba[i * width * 4];
+    }
+    if (passes > 1)
     {
-        row_pointers[i] = &row[i * width * 4];
+        png_read_image(png, row_pointers.data());
     }
-    png_read_image(png, row_pointers.data());
 
-    data.clear();
-    data.reserve(width * height);
-    for (size_t i = 0; i < row.size(); i += 4)
+    gray.resize(width);
+    if (color)
     {
-        unsigned char r = row[i],
-                      g = row[i + 1],
-                      b = row[i + 2],
-                      a = row[i + 3];
-        if (inverted)
+        rgb.resize(static_cast<size_t>(width) * 3);
+    }
+    for (unsigned int y = 0; y < height; ++y)
+    {
+        const png_byte *row;
+        if (passes > 1)
+        {
+            row = row_pointers[y];
+        }
+        else
+        {
+            png_read_row(png, row_pointers[0], nullptr);
+            row = row_pointers[0];
+        }
+
+        for (unsigned int x = 0; x < width; ++x)
         {
-            r = 255 - r;
-            g = 255 - g;
-            b = 255 - b;
-            if (a == 0)
+            unsigned char r = row[x * 4],
+                          g = row[x * 4 + 1],
+                          b = row[x * 4 + 2],
+                          a = row[x * 4 + 3];
+            if (inverted)
             {
-                a = 255;
+                r = 255 - r;
+                g = 255 - g;
+                b = 255 - b;
+                if (a == 0)
+                {
+                    a = 255;
+                }
             }
-        }
 
-        double gray_scale = (0.212671 * r / 255.0) + (0.715160f * g / 255.0) + (0.072169 * b / 255.0);
-        gray_scale *= a / 255.0;
-        data.push_back(static_cast<unsigned char>(gray_scale * 255));
+            double gray_scale = (0.212671 * r / 255.0) + (0.715160f * g / 255.0) + (0.072169 * b / 255.0);
+            gray_scale *= a / 255.0;
+            gray[x] = static_cast<unsigned char>(gray_scale * 255);
+            if (color)
+            { // transparent pixels are black like in the gray image
+                rgb[x * 3] = r * a / 255;
+                rgb[x * 3 + 1] = g * a / 255;
+                rgb[x * 3 + 2] = b * a / 255;
+            }
+        }
+        row_callback(gray.data(), color ? rgb.data() : nullptr, y);
     }
 
     png_destroy_read_struct(&png, &info, nullptr);
-    fclose(file);
 
     return true;
 }
@@ -0,0 +1,186 @@
+#include "ImageSource.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    /**
+     * @brief Image file mapped to memory, unmapped when the source is destroyed
+     */
+    class MappedSource : public ImageSource
+    {
+    public:
+        MappedSource(const std::string &name, void *mapping, size_t length) : ImageSource(name), mapping(mapping), length(length) {}
+
+        ~MappedSource() override
+        {
+            munmap(mapping, length);
+        }
+
+        const unsigned char *data() const override
+        {
+            return static_cast<const unsigned char *>(mapping);
+        }
+
+        size_t size() const override
+        {
+            return length;
+        }
+
+    private:
+        void *mapping;
+        size_t length;
+    };
+
+    /**
+     * @brief Memory of the caller
+     */
+    class MemorySource : public ImageSource
+    {
+    public:
+        MemorySource(const std::string &name, const unsigned char *bytes, size_t length) : ImageSource(name), bytes(bytes), length(length) {}
+
+        const unsigned char *data() const override
+        {
+            return bytes;
+        }
+
+        size_t size() const override
+        {
+            return length;
+        }
+
+    private:
+        const unsigned char *bytes;
+        size_t length;
+    };
+
+    /**
+     * @brief Buffer owned by the source
+     */
+    class BufferSource : public ImageSource
+    {
+    public:
+        BufferSource(const std::string &name, std::vector<unsigned char> buffer) : ImageSource(name), buffer(std::move(buffer)) {}
+
+        const unsigned char *data() const override
+        {
+            return buffer.data();
+        }
+
+        size_t size() const override
+        {
+            return buffer.size();
+        }
+
+    private:
+        std::vector<unsigned char> buffer;
+    };
+
+    /**
+     * @brief Read everything from the descriptor
+     * @return true if the end of the input was reached
+     */
+    bool readAll(int file, std::vector<unsigned char> &buffer)
+    {
+        unsigned char chunk[64 * 1024];
+        while (true)
+        {
+            ssize_t received = read(file, chunk, sizeof(chunk));
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (received < 0)
+            {
+                return false;
+            }
+            if (received == 0)
+            {
+                return true;
+            }
+            buffer.insert(buffer.end(), chunk, chunk + received);
+        }
+    }
+}
+
+std::unique_ptr<ImageSource> ImageSource::open(const std::string &path)
+{
+    return path == "-" ? fromStdin() : fromFile(path);
+}
+
+std::unique_ptr<ImageSource> ImageSource::fromFile(const std::string &path)
+{
+    int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+    {
+        return nullptr;
+    }
+
+    struct stat info;
+    if (fstat(file, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping != MAP_FAILED)
+        { // the mapping stays valid after the descriptor is closed
+            close(file);
+            // the decoders read the file from the start to the end just once
+            madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+            return std::make_unique<MappedSource>(path, mapping, info.st_size);
+        }
+    }
+
+    std::vector<unsigned char> buffer;
+    bool complete = readAll(file, buffer);
+    close(file);
+    if (!complete)
+    {
+        return nullptr;
+    }
+    return fromBuffer(std::move(buffer), path);
+}
+
+std::unique_ptr<ImageSource> ImageSource::fromStdin()
+{
+    std::vector<unsigned char> buffer;
+    if (!readAll(STDIN_FILENO, buffer))
+    {
+        return nullptr;
+    }
+    return fromBuffer(std::move(buffer), "-");
+}
+
+std::unique_ptr<ImageSource> ImageSource::fromMemory(const unsigned char *data, size_t size, const std::string &name)
+{
+    return std::make_unique<MemorySource>(name, data, size);
+}
+
+std::unique_ptr<ImageSource> ImageSource::fromBuffer(std::vector<unsigned char> buffer, const std::string &name)
+{
+    return std::make_unique<BufferSource>(name, std::move(buffer));
+}
+
+ImageSource::Format ImageSource::format() const
+{
+    static const unsigned char PNG_MAGIC[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    static const unsigned char JPEG_MAGIC[] = {0xFF, 0xD8, 0xFF};
+
+    if (size() >= sizeof(PNG_MAGIC) && std::memcmp(data(), PNG_MAGIC, sizeof(PNG_MAGIC)) == 0)
+    {
+        return Format::PNG;
+    }
+    if (size() >= sizeof(JPEG_MAGIC) && std::memcmp(data(), JPEG_MAGIC, sizeof(JPEG_MAGIC)) == 0)
+    {
+        return Format::JPEG;
+    }
+    return Format::Unknown;
+}
+
+const std::string &ImageSource::name() const
+{
+    return source_name;
+}
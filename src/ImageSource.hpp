@@ -0,0 +1,96 @@
+#ifndef ASCII_ART_IMAGESOURCE_HPP
+#define ASCII_ART_IMAGESOURCE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief "Abstract" source of the bytes of an encoded image (a file mapped to memory, a memory buffer, stdin)
+ *
+ * @details The decoders read the whole encoded image straight from memory (jpeg_mem_src, libpng read function),
+ * a mapped file is decoded from the page cache without copying it. The format of the image is detected from
+ * its magic bytes, so the extension of the file does not matter.
+ */
+class ImageSource
+{
+public:
+    /**
+     * @brief Formats of the images recognized by their magic bytes
+     */
+    enum class Format
+    {
+        Unknown,
+        JPEG,
+        PNG
+    };
+
+    virtual ~ImageSource() = default;
+
+    /**
+     * @brief Open the image file, "-" reads the image from the standard input
+     * @param path The path to the image or "-"
+     * @return std::unique_ptr<ImageSource> the source, nullptr if the file can't be opened
+     */
+    static std::unique_ptr<ImageSource> open(const std::string &path);
+
+    /**
+     * @brief Map the image file to memory, files which can't be mapped (pipes, ...) are read to a buffer
+     * @param path The path to the image
+     * @return std::unique_ptr<ImageSource> the source, nullptr if the file can't be opened
+     */
+    static std::unique_ptr<ImageSource> fromFile(const std::string &path);
+
+    /**
+     * @brief Read the whole standard input to a buffer
+     * @return std::unique_ptr<ImageSource> the source, nullptr if the input can't be read
+     */
+    static std::unique_ptr<ImageSource> fromStdin();
+
+    /**
+     * @brief Use the memory of the caller, nothing is copied, the memory must outlive the source
+     * @param data The bytes of the encoded image
+     * @param size Number of the bytes
+     * @param name Name of the image used in the messages and the trace
+     * @return std::unique_ptr<ImageSource> the source
+     */
+    static std::unique_ptr<ImageSource> fromMemory(const unsigned char *data, size_t size, const std::string &name = "memory");
+
+    /**
+     * @brief Take over the buffer with the bytes of the encoded image
+     * @param buffer The bytes of the encoded image
+     * @param name Name of the image used in the messages and the trace
+     * @return std::unique_ptr<ImageSource> the source
+     */
+    static std::unique_ptr<ImageSource> fromBuffer(std::vector<unsigned char> buffer, const std::string &name = "memory");
+
+    /**
+     * @brief Get the bytes of the encoded image
+     */
+    virtual const unsigned char *data() const = 0;
+
+    /**
+     * @brief Get the number of the bytes of the encoded image
+     */
+    virtual size_t size() const = 0;
+
+    /**
+     * @brief Detect the format of the image from its magic bytes
+     * @return Format the format, Format::Unknown if it is not supported
+     */
+    Format format() const;
+
+    /**
+     * @brief Get the name of the image (path, "-" for stdin)
+     */
+    const std::string &name() const;
+
+protected:
+    explicit ImageSource(const std::string &name) : source_name(name) {}
+
+private:
+    std::string source_name;
+};
+
+#endif // ASCII_ART_IMAGESOURCE_HPP
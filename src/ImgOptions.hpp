@@ -1,7 +1,113 @@
 #ifndef ASCII_ART_IMGOPTIONS_HPP
 #define ASCII_ART_IMGOPTIONS_HPP
 
+#include <cstddef>
+#include <memory>
 #include <string>
+#include <vector>
+
+/**
+ * @brief Colours of the console output
+ */
+enum class ColorMode
+{
+    None,       // monochrome text
+    Palette256, // 256-colour ANSI escapes (xterm palette)
+    TrueColor   // 24-bit ANSI escapes
+};
+
+/**
+ * @brief How the glyph of an output cell is chosen from the source pixels
+ */
+enum class Sampling
+{
+    Nearest, // brightness of the single nearest pixel
+    Area,    // brightness of the mean of all pixels the cell covers
+    Shape    // glyph whose shape matches the pixels of the cell best, flat cells as Area (see GlyphMasks)
+};
+
+/**
+ * @brief What the cells of the output text are made of
+ */
+enum class CellMode
+{
+    Charset,  // one glyph of the charset per sample
+    Braille,  // 2 x 4 samples per cell as the dots of a braille pattern (U+2800 - U+28FF)
+    HalfBlock // 2 samples per cell as half blocks (U+2580, U+2584, U+2588), with colours the foreground and the background of U+2580
+};
+
+/**
+ * @brief Get the number of the samples of a cell along the line
+ */
+inline unsigned int cellColumns(CellMode cells)
+{
+    return cells == CellMode::Braille ? 2 : 1;
+}
+
+/**
+ * @brief Get the number of the samples of a cell across the lines
+ */
+inline unsigned int cellRows(CellMode cells)
+{
+    return cells == CellMode::Braille ? 4 : cells == CellMode::HalfBlock ? 2 : 1;
+}
+
+/**
+ * @brief How the gray levels are quantised to the glyphs of the charset (or to the dots of the cells)
+ */
+enum class Dithering
+{
+    None,      // the nearest lower glyph, flat areas band
+    Bayer4,    // ordered dither with the 4 x 4 Bayer matrix as the threshold offsets
+    Bayer8,    // ordered dither with the 8 x 8 Bayer matrix
+    BlueNoise, // ordered dither with a tiled 32 x 32 blue-noise matrix, no visible pattern
+    Diffusion  // Floyd-Steinberg error diffusion, the best quality but serial
+};
+
+/**
+ * @brief Point operation on the gray levels of the pixels, the operations of an image are applied in the given order
+ */
+struct ToneOp
+{
+    enum class Kind
+    {
+        Contrast,  // (gray - 128) * first + 128
+        Gamma,     // 255 * (gray / 255)^(1 / first)
+        Levels,    // stretches [first, second] to [0, 255]
+        Threshold, // 255 from first up, 0 below
+        Posterize, // first levels of gray
+        Negate     // 255 - gray
+    };
+    Kind kind;
+    double first = 0;
+    double second = 0;
+};
+
+/**
+ * @brief Convolution of the gray pixels, the filters and the tone operations of an image are applied in the order of the arguments
+ */
+struct FilterOp
+{
+    enum class Kind
+    {
+        Blur,    // gaussian blur with the standard deviation sigma
+        Sharpen, // unsharp mask: gray + amount * (gray - blurred gray), blurred with sigma
+        Edges    // magnitude of the Sobel gradient
+    };
+    Kind kind;
+    double sigma = 1; // in the pixels of the original image
+    double amount = 0;
+    size_t tone_before = 0; // number of the tone operations given before the filter, they are applied to the pixels first
+};
+
+/**
+ * @brief Get the default charset, one immutable string shared by all images which don't set their own
+ */
+inline const std::shared_ptr<const std::string> &defaultCharset()
+{
+    static const std::shared_ptr<const std::string> charset = std::make_shared<const std::string>(" .'`^,:;Il!i><~+_-?][}{1)(|/tfjrxnuvczXYUJCLQ0OZmwqpdbkhao*#MW&8%B@$");
+    return charset;
+}
 
 /**
  * @brief Struct for storing the configuration of an image
@@ -9,13 +115,22 @@
 struct Img
 {
     std::string image_path;
-    std::string charset = " .'`^,:;Il!i><~+_-?][}{1)(|/tfjrxnuvczXYUJCLQ0OZmwqpdbkhao*#MW&8%B@$";
+    std::shared_ptr<const std::string> charset = defaultCharset(); // immutable, shared by the images with the same charset file
     double brightness = 2;
     double scale = 1.0;
+    unsigned int columns = 0; // cells per line the image is fitted to, 0 if the scale decides
+    unsigned int lines = 0; // lines the image is fitted to, 0 if the scale decides
+    double cell_aspect = 0; // width / height of an output cell, 0 until the output sets it (the lines are sampled sparser)
     bool invert = false;
     int rotate = 0;
     bool flip_horizontal = false;
     bool flip_vertical = false;
     bool fancy = false;
+    Sampling sampling = Sampling::Nearest;
+    CellMode cells = CellMode::Charset; // the text is UTF-8 unless the cells are glyphs of the charset
+    Dithering dither = Dithering::None; // ignored by the shape matching of the glyphs
+    ColorMode color = ColorMode::None; // colour of the cells printed to the console
+    std::vector<ToneOp> tone; // point operations in the order of the arguments, compiled to one ToneCurve
+    std::vector<FilterOp> filters; // convolutions in the order of the arguments, see Convolution
 };
 #endif // ASCII_ART_IMGOPTIONS_HPP
@@ -0,0 +1,14 @@
+#include "Output.hpp"
+#include <algorithm>
+
+int Output::fontSize(const Image &image, const Img &img)
+{
+    double max_f_size;
+    int font_size = 1;
+    if (img.fancy)
+    {
+        max_f_size = std::min(16000.0 / image.ascii_width, 16000.0 / image.ascii_height);
+        font_size = std::max(1.0, std::min(15.0 * img.scale, max_f_size));
+    }
+    return font_size;
+}
@@ -23,6 +23,14 @@ public:
      * @return True if output was successful, false otherwise
      */
     virtual bool output(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, std::string path = "") const = 0;
+
+    /**
+     * @brief Get the size of the font (and of the cell of one character) the image is rendered with
+     * @param image The image with the converted ascii image
+     * @param img Configuration of the image (scale, fancy)
+     * @return int the font size, as big as possible with --fancy (up to 16000 pixels of the rendered image), 1 otherwise
+     */
+    static int fontSize(const Image &image, const Img &img);
     
     /**
      * @brief Path to the font used for the presentation and image output
@@ -1,6 +1,7 @@
 #include "OutputFile.hpp"
 #include <fstream>
 #include <iostream>
+#include "Trace.hpp"
 
 bool OutputFile::output(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, std::string path) const
 {
@@ -13,6 +14,7 @@ bool OutputFile::output(const std::vector<std::pair<std::unique_ptr<Image>, Img>
 
     for (const auto &pair : images)
     {
+        Trace::Span span("OutputFile::write", pair.second.image_path, pair.second.scale);
         file << pair.first->ascii_image << "\n\n";
     }
 
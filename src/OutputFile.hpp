@@ -8,6 +8,7 @@
  */
 class OutputFile : public Output
 {
+public:
     bool output(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, std::string path = "") const override;
 };
 
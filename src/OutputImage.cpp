@@ -1,127 +1,144 @@
 #include "OutputImage.hpp"
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
+#include <algorithm>
 #include <iostream>
+#include "png.h"
+#include "Trace.hpp"
+
+OutputImage::OutputImage(size_t jobs) : jobs(jobs)
+{
+}
 
 bool OutputImage::output(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, std::string) const
 {
-    if (SDL_Init(SDL_INIT_VIDEO) != 0)
+    // only the font rasteriser is needed, no video subsystem
+    if (TTF_Init() == -1)
     {
         return false;
     }
 
-    if (TTF_Init() == -1)
+    ThreadPool pool(jobs);
+    for (const auto &image : images)
     {
-        SDL_Quit();
-        return false;
+        // the image from the standard input has no path to be saved next to
+        const std::string &path = image.second.image_path;
+        std::string image_output_name = (path == "-" ? "stdin" : path.substr(0, path.size() - 4)) + "_ascii.png";
+        FILE *file = fopen(image_output_name.c_str(), "wb");
+        bool saved = file && render(*image.first, image.second, [file](const unsigned char *data, size_t size)
+                                    { return fwrite(data, 1, size, file) == size; },
+                                    pool);
+        if (file && fclose(file) != 0)
+        {
+            saved = false;
+        }
+        if (!saved)
+        {
+            GlyphAtlas::clear();
+            TTF_Quit();
+            return false;
+        }
+        std::cout << "Image saved to " << image_output_name << std::endl;
     }
 
-    if (IMG_Init(IMG_INIT_PNG) != IMG_INIT_PNG)
+    GlyphAtlas::clear();
+    TTF_Quit();
+
+    return true;
+}
+
+bool OutputImage::render(const Image &image, const Img &img, const PngSink &sink, ThreadPool &pool) const
+{
+    int font_size = fontSize(image, img);
+
+    // Due to old ProgTest library version, I am unable to use TTF_SetFontSize, the atlas keeps one font per size
+    GlyphAtlas *atlas = GlyphAtlas::get(FONT_PATH, font_size);
+    if (!atlas)
     {
-        TTF_Quit();
-        SDL_Quit();
         return false;
     }
 
-    SDL_Window *window = SDL_CreateWindow("ASCII-ART", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 0, 0, SDL_WINDOW_HIDDEN);
-    SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    TTF_Font *font = TTF_OpenFont(FONT_PATH, 1);
+    Trace::Span span("OutputImage::render", img.image_path, img.scale);
+    TextRasterizer rasterizer(*atlas, image, font_size);
+    span.setSize(rasterizer.width(), rasterizer.height());
+    return writePng(rasterizer, sink, pool);
+}
 
-    for (const auto &image : images)
+namespace
+{
+    void writeData(png_structp png, png_bytep data, png_size_t size)
     {
-        double max_f_size;
-        int font_size = 1;
-        if (image.second.fancy)
+        const OutputImage::PngSink &sink = *static_cast<const OutputImage::PngSink *>(png_get_io_ptr(png));
+        if (!sink(data, size))
         {
-            max_f_size = std::min(16000.0 / (image.first->width * image.second.scale), 16000.0 / (image.first->height * image.second.scale));
-            font_size = std::max(1.0, std::min(15.0 * image.second.scale, max_f_size));
+            png_error(png, "Write error");
         }
+    }
 
-        // Due to old ProgTest library version, I am unable to use TTF_SetFontSize
-        TTF_CloseFont(font);
-        font = TTF_OpenFont(FONT_PATH, font_size);
+    void flushData(png_structp)
+    {
+    }
+}
 
-        if (!window || !renderer || !font)
-        {
-            if (font)
-            {
-                TTF_CloseFont(font);
-            }
-
-            if (renderer)
-            {
-                SDL_DestroyRenderer(renderer);
-            }
-
-            if (window)
-            {
-                SDL_DestroyWindow(window);
-            }
-
-            IMG_Quit();
-            TTF_Quit();
-            SDL_Quit();
-            return false;
-        }
+bool OutputImage::writePng(const TextRasterizer &rasterizer, const PngSink &sink, ThreadPool &pool) const
+{
+    const unsigned int width = rasterizer.width(), height = rasterizer.height();
+    if (width == 0 || height == 0)
+    {
+        return false;
+    }
 
-        SDL_RenderClear(renderer);
-        SDL_Texture *texture = image.first->createTexture(renderer, font, font_size, image.second.scale);
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if (!png)
+    {
+        return false;
+    }
 
-        if (!texture)
-        {
-            TTF_CloseFont(font);
-            SDL_DestroyRenderer(renderer);
-            SDL_DestroyWindow(window);
-            IMG_Quit();
-            TTF_Quit();
-            SDL_Quit();
-            return false;
-        }
+    // declared before setjmp, so it is destroyed when libpng jumps back with an error
+    std::vector<unsigned char> rows;
 
-        SDL_SetRenderTarget(renderer, texture);
-        int width, height;
-        SDL_QueryTexture(texture, NULL, NULL, &width, &height);
-        SDL_Surface *surface = SDL_CreateRGBSurface(0, width, height, 32, 0, 0, 0, 0);
+    png_infop info = png_create_info_struct(png);
+    if (!info)
+    {
+        png_destroy_write_struct(&png, nullptr);
+        return false;
+    }
 
-        if (!surface || SDL_RenderReadPixels(renderer, NULL, surface->format->format, surface->pixels, surface->pitch) != 0)
-        {
-            TTF_CloseFont(font);
-            SDL_DestroyTexture(texture);
-            SDL_DestroyRenderer(renderer);
-            SDL_DestroyWindow(window);
-            IMG_Quit();
-            TTF_Quit();
-            SDL_Quit();
-            return false;
-        }
+    if (setjmp(png_jmpbuf(png)))
+    { // Error handling
+        png_destroy_write_struct(&png, &info);
+        return false;
+    }
+
+    png_set_write_fn(png, const_cast<PngSink *>(&sink), writeData, flushData);
+    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_GRAY, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(png, info);
 
-        std::string image_output_name = image.second.image_path.substr(0, image.second.image_path.size() - 4) + "_ascii.png";
-        const char *out = image_output_name.c_str();
+    // a few bands per thread are rendered at once, only these rows are kept in memory
+    const unsigned int BAND = 32;
+    const unsigned int chunk = BAND * 4 * pool.size();
+    rows.resize(static_cast<size_t>(std::min(chunk, height)) * width);
 
-        if (IMG_SavePNG(surface, out) != 0)
+    for (unsigned int chunk_start = 0; chunk_start < height; chunk_start += chunk)
+    {
+        unsigned int chunk_end = std::min(chunk_start + chunk, height);
+        for (unsigned int band = chunk_start; band < chunk_end; band += BAND)
         {
-            TTF_CloseFont(font);
-            SDL_DestroyTexture(texture);
-            SDL_DestroyRenderer(renderer);
-            SDL_DestroyWindow(window);
-            IMG_Quit();
-            TTF_Quit();
-            SDL_Quit();
-            return false;
+            unsigned int band_end = std::min(band + BAND, chunk_end);
+            unsigned char *out = rows.data() + static_cast<size_t>(band - chunk_start) * width;
+            pool.submit([&rasterizer, band, band_end, out]
+                        {
+                Trace::Span span("TextRasterizer::renderRows");
+                rasterizer.renderRows(band, band_end, out); });
         }
-        std::cout << "Image saved to " << image_output_name << std::endl;
+        pool.wait();
 
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+        for (unsigned int row = chunk_start; row < chunk_end; ++row)
+        {
+            png_write_row(png, rows.data() + static_cast<size_t>(row - chunk_start) * width);
+        }
     }
 
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(window);
-    TTF_CloseFont(font);
-    IMG_Quit();
-    TTF_Quit();
-    SDL_Quit();
-
+    png_write_end(png, nullptr);
+    png_destroy_write_struct(&png, &info);
     return true;
-}
\ No newline at end of file
+}
@@ -1,15 +1,53 @@
 #ifndef ASCII_ART_OUTPUTIMAGE_HPP
 #define ASCII_ART_OUTPUTIMAGE_HPP
 
+#include <functional>
 #include "Output.hpp"
+#include "TextRasterizer.hpp"
+#include "ThreadPool.hpp"
 
 /**
  * @brief Class for outputting the images to a png file
+ *
+ * @details The images are rendered on the CPU (TextRasterizer) and written by libpng, no display or renderer is needed.
  */
 class OutputImage : public Output
 {
 public:
+    /**
+     * @brief Construct a new OutputImage
+     * @param jobs Number of threads rendering the images, 0 means ThreadPool::defaultThreads()
+     */
+    explicit OutputImage(size_t jobs = 0);
+
     bool output(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, std::string path = "") const override;
+
+    /**
+     * @brief Receives the encoded png data, returns false if the data can't be written
+     */
+    using PngSink = std::function<bool(const unsigned char *data, size_t size)>;
+
+    /**
+     * @brief Render the image and encode it to png, TTF must be initialised and the glyph atlases are kept for the next images
+     * @param image The image with the converted ascii image
+     * @param img Configuration of the image (scale, fancy)
+     * @param sink Receives the encoded png data
+     * @param pool Pool rendering the bands of the image
+     * @return true if the image was rendered and written successfully
+     */
+    bool render(const Image &image, const Img &img, const PngSink &sink, ThreadPool &pool) const;
+
+private:
+    /**
+     * @brief Render the image in bands in parallel and encode the rows to a grayscale png as they are finished
+     * @param rasterizer The rasterizer of the image
+     * @param sink Receives the encoded png data
+     * @param pool Pool rendering the bands
+     * @return true if the png was written successfully
+     */
+    bool writePng(const TextRasterizer &rasterizer, const PngSink &sink, ThreadPool &pool) const;
+
+    size_t jobs;
 };
 
 #endif // ASCII_ART_OUTPUTIMAGE_HPP
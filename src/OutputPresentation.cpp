@@ -2,6 +2,11 @@
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL.h>
 #include <iostream>
+#include "SlideCache.hpp"
+
+OutputPresentation::OutputPresentation(size_t memory_limit) : memory_limit(memory_limit)
+{
+}
 
 bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, std::string) const
 {
@@ -27,16 +32,10 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
     }
 
     SDL_Window *window = SDL_CreateWindow("ASCII-ART", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, windowWidth, windowHeight, SDL_WINDOW_SHOWN);
-    TTF_Font *font = TTF_OpenFont(FONT_PATH, 1);
     SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
-    if (!window || !renderer || !font)
+    if (!window || !renderer)
     {
-        if (font)
-        {
-            TTF_CloseFont(font);
-        }
-
         if (renderer)
         {
             SDL_DestroyRenderer(renderer);
@@ -52,39 +51,25 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
         return false;
     }
 
-    std::vector<SDL_Texture *> textures;
-    for (const auto &image : images)
+    // slides are rendered when they are shown (and their neighbours in the background), not all of them up front
+    auto slides = std::make_unique<SlideCache>(images, FONT_PATH, memory_limit);
+    SDL_Texture *texture = slides->texture(renderer, 0);
+    if (texture == nullptr)
     {
-        double max_f_size;
-        int font_size = 1;
-        if (image.second.fancy)
-        {
-            max_f_size = std::min(16000.0 / (image.first->width * image.second.scale), 16000.0 / (image.first->height * image.second.scale));
-            font_size = std::max(1.0, std::min(15.0 * image.second.scale, max_f_size));
-        }
-
-        // Due to old ProgTest library version, I am unable to use TTF_SetFontSize
-        TTF_CloseFont(font);
-        font = TTF_OpenFont(FONT_PATH, font_size);
-
-        SDL_Texture *texture = image.first->createTexture(renderer, font, font_size, image.second.scale);
-        if (texture == nullptr)
-        {
-            TTF_CloseFont(font);
-            SDL_DestroyRenderer(renderer);
-            SDL_DestroyWindow(window);
-            TTF_Quit();
-            SDL_Quit();
-            return false;
-        }
-        textures.push_back(texture);
+        slides.reset();
+        GlyphAtlas::clear();
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        TTF_Quit();
+        SDL_Quit();
+        return false;
     }
 
     SDL_SetRenderTarget(renderer, NULL);
     SDL_Texture *onTexture = nullptr, *offTexture = nullptr;
     SDL_Rect autoplay_pos;
     TTF_Font *font2 = TTF_OpenFont(FONT_PATH, 17);
-    if (textures.size() > 1)
+    if (slides->size() > 1)
     {
         // AutoPlay indicator texture
         SDL_Color textColor = {255, 0, 0, 255};
@@ -98,9 +83,8 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
     }
 
     int offsetX = 0, offsetY = 0, current_texture_idx = 0;
-    SDL_Texture *texture = textures[0];
 
-    bool mouseDown = false, quit = false, is_autoplay = false;
+    bool mouseDown = false, quit = false, is_autoplay = false, failed = false;
     Uint32 start_time = SDL_GetTicks();
     Uint32 delay = 3000; // 3s
 
@@ -109,10 +93,10 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
 
     while (!quit)
     {
-        if (is_autoplay && SDL_GetTicks() - start_time > delay && textures.size() > 1)
+        if (is_autoplay && SDL_GetTicks() - start_time > delay && slides->size() > 1)
         {
-            current_texture_idx = (current_texture_idx + 1) % textures.size();
-            texture = textures[current_texture_idx];
+            current_texture_idx = (current_texture_idx + 1) % slides->size();
+            texture = slides->texture(renderer, current_texture_idx);
             start_time = SDL_GetTicks();
             scale = 1;
             offsetY = 0;
@@ -139,19 +123,19 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
                 }
                 else if (e.key.keysym.sym == SDLK_RIGHT)
                 {
-                    current_texture_idx = (current_texture_idx + 1) % textures.size();
+                    current_texture_idx = (current_texture_idx + 1) % slides->size();
                     scale = 1;
                     offsetY = 0;
                     offsetX = 0;
-                    texture = textures[current_texture_idx];
+                    texture = slides->texture(renderer, current_texture_idx);
                 }
                 else if (e.key.keysym.sym == SDLK_LEFT)
                 {
-                    current_texture_idx = (current_texture_idx - 1 + textures.size()) % textures.size();
+                    current_texture_idx = (current_texture_idx - 1 + slides->size()) % slides->size();
                     scale = 1;
                     offsetY = 0;
                     offsetX = 0;
-                    texture = textures[current_texture_idx];
+                    texture = slides->texture(renderer, current_texture_idx);
                 }
                 else if (e.key.keysym.sym == SDLK_SPACE)
                 {
@@ -193,6 +177,12 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
             }
         }
 
+        if (texture == nullptr)
+        {
+            failed = true;
+            break;
+        }
+
         SDL_RenderClear(renderer);
         SDL_RenderSetScale(renderer, scale, scale);
 
@@ -215,7 +205,7 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
 
         SDL_RenderCopy(renderer, texture, NULL, &dstRect);
 
-        if (textures.size() > 1 && scale <= 1.1)
+        if (slides->size() > 1 && scale <= 1.1)
         {
             if (is_autoplay)
             {
@@ -230,18 +220,15 @@ bool OutputPresentation::output(const std::vector<std::pair<std::unique_ptr<Imag
         SDL_RenderPresent(renderer);
     }
 
-    for (auto &t_ : textures)
-    {
-        SDL_DestroyTexture(t_);
-    }
+    slides.reset();
+    GlyphAtlas::clear();
     SDL_DestroyTexture(onTexture);
     SDL_DestroyTexture(offTexture);
     TTF_CloseFont(font2);
-    TTF_CloseFont(font);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     TTF_Quit();
     SDL_Quit();
 
-    return true;
+    return !failed;
 }
\ No newline at end of file
@@ -2,14 +2,26 @@
 #define ASCII_ART_OUTPUTPRESENTATION_HPP
 
 #include "Output.hpp"
+#include "SlideCache.hpp"
 
 /**
  * @brief Class for outputting the images to the screen presentation
+ *
+ * @details The slides are rendered on demand by SlideCache, so the first slide is shown without waiting for the others.
  */
 class OutputPresentation : public Output
 {
 public:
+    /**
+     * @brief Construct a new OutputPresentation
+     * @param memory_limit Limit of the memory of the slide textures in bytes
+     */
+    explicit OutputPresentation(size_t memory_limit = SlideCache::DEFAULT_MEMORY_LIMIT);
+
     bool output(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, std::string path = "") const override;
+
+private:
+    size_t memory_limit;
 };
 
 #endif // ASCII_ART_OUTPUTPRESENTATION_HPP
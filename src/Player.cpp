@@ -0,0 +1,246 @@
+#include "Player.hpp"
+#include <csignal>
+#include <thread>
+#include "Trace.hpp"
+#include "Utf8.hpp"
+
+namespace
+{
+    /**
+     * @brief Unchanged cells between two changed runs of a line which are written rather than skipped by another
+     * cursor escape (the escape itself takes about as many bytes)
+     */
+    const size_t MAX_GAP = 8;
+
+    /**
+     * @brief Longest sleep, so Ctrl+C stops even a very slow animation promptly
+     */
+    const std::chrono::milliseconds POLL_INTERVAL(50);
+
+    volatile std::sig_atomic_t interrupted = 0;
+
+    void onInterrupt(int)
+    {
+        interrupted = 1;
+    }
+
+    /**
+     * @brief Find the byte offsets of the cells of the line starting at the position, the last one is the line end
+     * @return size_t the position of the next line
+     */
+    size_t cellOffsets(const std::string &text, size_t position, unsigned int cells, std::vector<size_t> &offsets)
+    {
+        offsets.resize(static_cast<size_t>(cells) + 1);
+        for (unsigned int x = 0; x < cells; ++x)
+        {
+            offsets[x] = position;
+            position += Utf8::length(text[position]);
+        }
+        offsets[cells] = position;
+        return position + 1;
+    }
+}
+
+Player::Player(std::unique_ptr<FrameSource> frames, const Img &img, double fps, std::ostream &out)
+    : frames(std::move(frames)), img(img), fps(fps), out(out), decoding_finished(false), started(false), stopping(false), decode_failed(false), dropped(0),
+      screen_width(0), screen_height(0), output_bytes(0)
+{
+    if (this->fps <= 0)
+    {
+        this->fps = this->frames->fps() > 0 ? this->frames->fps() : DEFAULT_FPS;
+    }
+    period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / this->fps));
+    // the cells are compared by their glyphs only, the animation is monochrome
+    this->img.color = ColorMode::None;
+}
+
+bool Player::run()
+{
+    interrupted = 0;
+    auto previous_handler = std::signal(SIGINT, onInterrupt);
+    out << "\x1b[?25l"; // hide the cursor
+
+    std::thread decoder(&Player::decodeFrames, this);
+
+    size_t shown = 0, last_index = 0;
+    while (!interrupted)
+    {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            while (queue.empty() && !decoding_finished && !interrupted)
+            {
+                changed.wait_for(guard, POLL_INTERVAL);
+            }
+            if (queue.empty())
+            {
+                break;
+            }
+            frame = std::move(queue.front());
+            queue.pop_front();
+            if (!started)
+            { // the clock starts with the first frame, not with the opening of the source
+                start = std::chrono::steady_clock::now();
+                started = true;
+            }
+        }
+        changed.notify_all();
+
+        auto deadline = start + period * frame.index;
+        while (!interrupted && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(deadline - std::chrono::steady_clock::now(), POLL_INTERVAL));
+        }
+        draw(*frame.image);
+        shown++;
+        last_index = frame.index;
+    }
+
+    // the last frame stays on the screen for its period as well
+    auto end = start + period * (last_index + 1);
+    while (shown > 0 && !interrupted && std::chrono::steady_clock::now() < end)
+    {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(end - std::chrono::steady_clock::now(), POLL_INTERVAL));
+    }
+    stopping = true;
+    changed.notify_all();
+    decoder.join();
+
+    output.clear();
+    if (shown > 0)
+    { // below the frame
+        moveCursor(screen_height, 0);
+    }
+    output += "\x1b[?25h"; // show the cursor again
+    out << output;
+    std::signal(SIGINT, previous_handler);
+
+    double elapsed = shown > 0 ? std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() : 0;
+    out << "Frames: " << shown << " shown, " << dropped << " dropped, " << (elapsed > 0 ? shown / elapsed : 0.0)
+        << " fps achieved of " << fps << ", " << (shown > 0 ? output_bytes / shown : 0) << " bytes per frame" << std::endl;
+    return !frames->failed() && !decode_failed;
+}
+
+void Player::decodeFrames()
+{
+    try
+    {
+        for (size_t index = 0; !stopping; ++index)
+        {
+            bool late;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [this]
+                             { return queue.size() < QUEUE_SIZE || stopping; });
+                if (stopping)
+                {
+                    break;
+                }
+                // the frame would be shown more than a period after its deadline
+                late = started && std::chrono::steady_clock::now() > start + period * (index + 1);
+            }
+
+            if (late)
+            {
+                if (!frames->skip())
+                {
+                    break;
+                }
+                dropped++;
+                continue;
+            }
+
+            std::unique_ptr<Image> image;
+            {
+                Trace::Span span("Player::decode");
+                image = frames->next(img);
+                if (image)
+                {
+                    span.setSize(image->width, image->height);
+                }
+            }
+            if (!image)
+            {
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                queue.push_back({index, std::move(image)});
+            }
+            changed.notify_all();
+        }
+    }
+    catch (std::exception &)
+    { // the frame can't be converted (out of memory, invalid options), the animation ends as if the source failed
+        decode_failed = true;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        decoding_finished = true;
+    }
+    changed.notify_all();
+}
+
+void Player::draw(const Image &frame)
+{
+    Trace::Span span("Player::draw");
+    const std::string &text = frame.ascii_image;
+    output.clear();
+    if (screen.empty() || frame.ascii_width != screen_width || frame.ascii_height != screen_height)
+    {
+        output += "\x1b[2J\x1b[H"; // clear the screen, the cursor goes home
+        output += text;
+    }
+    else
+    {
+        // the cells of a line may differ in their byte length, they are compared as whole characters
+        auto differs = [&](size_t x)
+        {
+            const size_t length = frame_cells[x + 1] - frame_cells[x];
+            return length != screen_cells[x + 1] - screen_cells[x] || text.compare(frame_cells[x], length, screen, screen_cells[x], length) != 0;
+        };
+        size_t frame_line = 0, screen_line = 0;
+        for (unsigned int y = 0; y < screen_height; ++y)
+        {
+            frame_line = cellOffsets(text, frame_line, screen_width, frame_cells);
+            screen_line = cellOffsets(screen, screen_line, screen_width, screen_cells);
+            size_t x = 0;
+            while (x < screen_width)
+            {
+                if (!differs(x))
+                {
+                    ++x;
+                    continue;
+                }
+                size_t last_changed = x;
+                for (size_t i = x + 1; i < screen_width && i - last_changed <= MAX_GAP; ++i)
+                {
+                    if (differs(i))
+                    {
+                        last_changed = i;
+                    }
+                }
+                moveCursor(y, x);
+                output.append(text, frame_cells[x], frame_cells[last_changed + 1] - frame_cells[x]);
+                x = last_changed + 1;
+            }
+        }
+    }
+
+    out.write(output.data(), output.size());
+    out.flush();
+    output_bytes += output.size();
+    screen.assign(text);
+    screen_width = frame.ascii_width;
+    screen_height = frame.ascii_height;
+}
+
+void Player::moveCursor(unsigned int row, unsigned int column)
+{
+    output += "\x1b[";
+    output += std::to_string(row + 1);
+    output += ';';
+    output += std::to_string(column + 1);
+    output += 'H';
+}
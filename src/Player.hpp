@@ -0,0 +1,116 @@
+#ifndef ASCII_ART_PLAYER_HPP
+#define ASCII_ART_PLAYER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "FrameSource.hpp"
+#include "Image.hpp"
+#include "ImgOptions.hpp"
+
+/**
+ * @brief Plays the frames of a FrameSource as an ascii animation in the terminal
+ *
+ * @details The frames are decoded and converted in the background while the current frame is shown, at most
+ * QUEUE_SIZE converted frames wait for their turn. Every frame has its deadline (start + index / fps); a frame whose
+ * deadline passed by more than one frame period before its decoding started is dropped without being decoded,
+ * so a slow source or terminal makes the animation skip frames instead of falling behind.
+ *
+ * Only the cells which changed since the previous frame are redrawn: the changed runs of every line are written
+ * after a cursor-addressing escape, short unchanged gaps between them are written as well (cheaper than another escape).
+ * The cells are UTF-8 characters (the braille and half block cells take several bytes), the lines are compared cell by cell.
+ * The whole frame is drawn only for the first frame and when the dimensions change.
+ */
+class Player
+{
+public:
+    /**
+     * @brief Number of the converted frames waiting to be shown
+     */
+    static constexpr size_t QUEUE_SIZE = 3;
+
+    /**
+     * @brief Frame rate used when neither the option nor the stream specify it
+     */
+    static constexpr double DEFAULT_FPS = 25;
+
+    /**
+     * @brief Construct a new Player, nothing is played yet
+     * @param frames The frames to play
+     * @param img Configuration of the conversion of the frames
+     * @param fps Frames per second, 0 means the rate of the stream or DEFAULT_FPS
+     * @param out Terminal the frames are drawn to
+     */
+    Player(std::unique_ptr<FrameSource> frames, const Img &img, double fps, std::ostream &out = std::cout);
+
+    /**
+     * @brief Play the frames until the end of the source or Ctrl+C, the statistics are printed afterwards
+     * @return true if all frames were read successfully
+     */
+    bool run();
+
+private:
+    struct Frame
+    {
+        size_t index;
+        std::unique_ptr<Image> image;
+    };
+
+    /**
+     * @brief Decode and convert the frames to the queue, runs on its own thread
+     */
+    void decodeFrames();
+
+    /**
+     * @brief Write the frame to the terminal, only the cells different from the previous frame
+     */
+    void draw(const Image &frame);
+
+    /**
+     * @brief Append the escape moving the cursor to the cell (0 based)
+     */
+    void moveCursor(unsigned int row, unsigned int column);
+
+    std::unique_ptr<FrameSource> frames;
+    Img img;
+    double fps;
+    std::ostream &out;
+    std::chrono::steady_clock::duration period;
+
+    std::mutex lock;
+    std::condition_variable changed;
+    std::deque<Frame> queue;
+    bool decoding_finished;
+    bool started;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<bool> stopping;
+    std::atomic<bool> decode_failed; // the conversion threw, the source itself didn't fail
+    std::atomic<size_t> dropped;
+
+    /**
+     * @brief The frame on the screen, compared with the next one
+     */
+    std::string screen;
+    unsigned int screen_width;
+    unsigned int screen_height;
+
+    /**
+     * @brief Byte offsets of the cells of the compared line in the frame and on the screen, reused by all lines
+     */
+    std::vector<size_t> frame_cells;
+    std::vector<size_t> screen_cells;
+
+    /**
+     * @brief Text written to the terminal for the frame, reused by all frames
+     */
+    std::string output;
+    size_t output_bytes;
+};
+
+#endif // ASCII_ART_PLAYER_HPP
@@ -0,0 +1,393 @@
+#include "Server.hpp"
+#include <SDL2/SDL_ttf.h>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "AnsiText.hpp"
+#include "Controller.hpp"
+#include "GlyphAtlas.hpp"
+
+namespace
+{
+    /**
+     * @brief Limit of the size of the arguments of a request
+     */
+    const size_t MAX_ARGUMENTS_SIZE = 1024 * 1024;
+
+    /**
+     * @brief Limit of the size of an inline image
+     */
+    const size_t MAX_DATA_SIZE = 512 * 1024 * 1024;
+
+    /**
+     * @brief Longest wait for the client to send or to take the next bytes, the clients are served one at a time
+     * and a silent one must not block the others
+     */
+    const int CLIENT_TIMEOUT_SECONDS = 10;
+
+    /**
+     * @brief Options a request may use with the number of their values, the others would make the server read its own
+     * standard input or terminal, write files or change its state (--play, --manifest, --conf, --cache-dir, --trace, ...)
+     */
+    const std::map<std::string, int> REQUEST_OPTIONS = {
+        {"--console", 0}, {"--file", 1}, {"--image", 0}, {"--ascii", 1}, {"--brightness", 1}, {"--scale", 1},
+        {"--invert", 0}, {"--rotate", 1}, {"--flip-horizontal", 0}, {"--flip-vertical", 0}, {"--fancy", 0},
+        {"--sampling", 1}, {"--cells", 1}, {"--dither", 1}, {"--color", 1}, {"--width", 1}, {"--height", 1},
+        {"--aspect", 1}, {"--edges", 0}, {"--blur", 1}, {"--sharpen", 1}, {"--negate", 0}, {"--contrast", 1},
+        {"--gamma", 1}, {"--levels", 1}, {"--threshold", 1}, {"--posterize", 1}};
+
+    volatile std::sig_atomic_t stopping = 0;
+
+    void stop(int)
+    {
+        stopping = 1;
+    }
+
+    /**
+     * @brief Buffered reading from the socket of the client
+     */
+    class Reader
+    {
+    public:
+        explicit Reader(int socket) : socket(socket), position(0), length(0) {}
+
+        /**
+         * @brief Read a single byte
+         * @return int the byte, -1 if the connection was closed or failed
+         */
+        int get()
+        {
+            if (position == length && !fill())
+            {
+                return -1;
+            }
+            return static_cast<unsigned char>(buffer[position++]);
+        }
+
+        /**
+         * @brief Read exactly size bytes to the file
+         * @return true if all bytes were read and written
+         */
+        bool copyTo(int file, size_t size)
+        {
+            while (size > 0)
+            {
+                if (position == length && !fill())
+                {
+                    return false;
+                }
+                size_t chunk = std::min(size, length - position);
+                if (write(file, buffer + position, chunk) != static_cast<ssize_t>(chunk))
+                {
+                    return false;
+                }
+                position += chunk;
+                size -= chunk;
+            }
+            return true;
+        }
+
+    private:
+        bool fill()
+        {
+            ssize_t received;
+            do
+            {
+                received = recv(socket, buffer, sizeof(buffer), 0);
+            } while (received < 0 && errno == EINTR);
+            position = 0;
+            length = received > 0 ? received : 0;
+            return received > 0;
+        }
+
+        int socket;
+        char buffer[64 * 1024];
+        size_t position;
+        size_t length;
+    };
+
+    bool sendAll(int socket, const char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (sent <= 0)
+            {
+                return false;
+            }
+            data += sent;
+            size -= sent;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Temporary files of the inline images, removed when the request is done
+     */
+    class TemporaryFiles
+    {
+    public:
+        ~TemporaryFiles()
+        {
+            for (const std::string &path : paths)
+            {
+                unlink(path.c_str());
+            }
+        }
+
+        /**
+         * @brief Create a new temporary file
+         * @param extension Extension of the file (.jpg, .png)
+         * @param path Output parameter for the path to the file
+         * @return int descriptor of the opened file, -1 on failure
+         */
+        int create(const std::string &extension, std::string &path)
+        {
+            std::string name = (std::filesystem::temp_directory_path() / "ascii-art-XXXXXX").string() + extension;
+            int file = mkstemps(&name[0], extension.size());
+            if (file >= 0)
+            {
+                paths.push_back(name);
+                path = name;
+            }
+            return file;
+        }
+
+    private:
+        std::vector<std::string> paths;
+    };
+}
+
+Server::Server(const std::string &socket_path, size_t jobs) : socket_path(socket_path), pool(jobs), output_image(jobs)
+{
+}
+
+bool Server::run()
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    std::strcpy(address.sun_path, socket_path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0)
+    {
+        return false;
+    }
+    unlink(socket_path.c_str()); // left over by a previous server
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        close(listener);
+        return false;
+    }
+
+    // no SA_RESTART, so the signal interrupts the waiting in accept
+    struct sigaction action{};
+    action.sa_handler = stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // the fonts and the glyph atlases are kept open for all requests
+    bool ttf = TTF_Init() == 0;
+    std::cout << "Serving on " << socket_path << std::endl;
+
+    while (!stopping)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            break;
+        }
+        timeval timeout{};
+        timeout.tv_sec = CLIENT_TIMEOUT_SECONDS;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        handle(client);
+        close(client);
+    }
+
+    close(listener);
+    unlink(socket_path.c_str());
+    GlyphAtlas::clear();
+    if (ttf)
+    {
+        TTF_Quit();
+    }
+    return stopping;
+}
+
+void Server::handle(int client)
+{
+    Reader reader(client);
+    std::vector<std::string> args;
+    std::string arg;
+    size_t total = 0;
+    bool complete = false;
+    for (int c; !complete && (c = reader.get()) != -1 && ++total <= MAX_ARGUMENTS_SIZE;)
+    {
+        if (c != '\0')
+        {
+            arg += static_cast<char>(c);
+        }
+        else if (arg.empty())
+        {
+            complete = true;
+        }
+        else
+        {
+            args.push_back(std::move(arg));
+            arg.clear();
+        }
+    }
+
+    std::string result, error;
+    TemporaryFiles files;
+    if (!complete)
+    {
+        error = "Incomplete request.";
+    }
+
+    // inline images are stored to temporary files and passed by path
+    std::vector<std::string> image_args;
+    for (size_t i = 0; error.empty() && i < args.size(); ++i)
+    {
+        if (args[i] != "--data")
+        {
+            image_args.push_back(args[i]);
+            continue;
+        }
+        if (i + 2 >= args.size())
+        {
+            error = "No inline image name or size provided.";
+            break;
+        }
+        std::string name = args[i + 1], extension = name.size() > 4 ? name.substr(name.size() - 4) : "";
+        char *end;
+        unsigned long long size = std::strtoull(args[i + 2].c_str(), &end, 10);
+        i += 2;
+        if (extension != ".jpg" && extension != ".png")
+        {
+            error = "Unsupported inline image " + name + ".";
+            break;
+        }
+        if (*end != '\0' || args[i].empty() || size > MAX_DATA_SIZE)
+        {
+            error = "Invalid inline image size.";
+            break;
+        }
+
+        std::string path;
+        int file = files.create(extension, path);
+        bool stored = file >= 0 && reader.copyTo(file, size);
+        if (file >= 0)
+        {
+            close(file);
+        }
+        if (!stored)
+        {
+            error = "Inline image can't be received.";
+            break;
+        }
+        image_args.push_back(path);
+    }
+
+    if (error.empty())
+    {
+        error = process(image_args, result);
+    }
+
+    std::string header = error.empty() ? "OK " + std::to_string(result.size()) + "\n" : "ERROR " + error + "\n";
+    if (sendAll(client, header.data(), header.size()) && error.empty())
+    {
+        sendAll(client, result.data(), result.size());
+    }
+}
+
+std::string Server::process(const std::vector<std::string> &args, std::string &result)
+{
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        auto option = REQUEST_OPTIONS.find(args[i]);
+        if (option != REQUEST_OPTIONS.end())
+        {
+            i += option->second;
+        }
+        else if (args[i] == "-" || args[i].compare(0, 2, "--") == 0)
+        { // "-" is the standard input of the server
+            return args[i] + " can't be used in a request.";
+        }
+    }
+
+    std::vector<std::string> arguments = {"app"};
+    arguments.insert(arguments.end(), args.begin(), args.end());
+    std::vector<char *> argv;
+    for (std::string &argument : arguments)
+    {
+        argv.push_back(&argument[0]);
+    }
+
+    try
+    {
+        Controller controller(argv.size(), argv.data(), pool);
+        if (!controller.processImages())
+        {
+            return "Error while loading images.";
+        }
+
+        const auto &images = controller.getImages();
+        if (controller.getOutputType() != "image")
+        { // the same as the console (--color) or OutputFile writes
+            for (const auto &image : images)
+            {
+                if (image.second.color == ColorMode::None)
+                {
+                    result += image.first->ascii_image + "\n\n";
+                }
+                else
+                {
+                    result += AnsiText::render(*image.first, image.second.color) + "\n\n";
+                }
+            }
+            return "";
+        }
+
+        if (images.size() != 1)
+        {
+            return "Only a single image can be rendered per request.";
+        }
+        bool rendered = output_image.render(*images.front().first, images.front().second, [&result](const unsigned char *data, size_t size)
+                                            {
+            result.append(reinterpret_cast<const char *>(data), size);
+            return true; },
+                                            pool);
+        return rendered ? "" : "Error while rendering the image.";
+    }
+    catch (std::exception &e)
+    {
+        if (e.what() == std::string("stoi") || e.what() == std::string("stod"))
+        {
+            return "Incorrect operation value.";
+        }
+        return e.what();
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef ASCII_ART_SERVER_HPP
+#define ASCII_ART_SERVER_HPP
+
+#include <string>
+#include <vector>
+#include "OutputImage.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @brief Long-lived server converting images on requests coming over a unix domain socket (--serve)
+ *
+ * @details The process, the thread pool, the fonts with their glyph atlases and the gray -> glyph tables stay warm
+ * between the requests, so a request costs only the conversion itself.
+ *
+ * Request: the same arguments as on the command line, every one terminated by '\0', the list terminated by an empty
+ * argument. Only the outputs --console, --file and --image and the options of the images are accepted, the options
+ * of the process (--play, --manifest, --conf, --cache-dir, --trace, --jobs, ...) and the standard input "-" are not. Instead of a path, an image can be sent inline as the arguments "--data name size" (the extension of the name
+ * gives the format), its size bytes follow the list of arguments (in the order of the --data arguments).
+ *
+ * Response: "OK size\n" followed by size bytes of the result, or "ERROR message\n".
+ * The result is the png of the image for --image (a single image per request), the ascii images separated by an empty
+ * line otherwise (--console, --file). Requests are served one at a time, the images of a request are processed in parallel.
+ * A client which doesn't send or receive anything for 10 seconds is disconnected, so it can't block the others.
+ */
+class Server
+{
+public:
+    /**
+     * @brief Construct a new Server
+     * @param socket_path Path of the socket to listen on, an existing socket file is replaced
+     * @param jobs Number of threads processing the images, 0 means ThreadPool::defaultThreads()
+     */
+    Server(const std::string &socket_path, size_t jobs);
+
+    /**
+     * @brief Serve the requests until SIGINT or SIGTERM
+     * @return true if the server stopped on a signal, false if the socket can't be used
+     */
+    bool run();
+
+private:
+    /**
+     * @brief Read the request from the client, process it and send the response
+     * @param client Socket of the client
+     */
+    void handle(int client);
+
+    /**
+     * @brief Process the arguments of the request
+     * @param args The arguments (with the inline images already replaced by their temporary files)
+     * @param result Output parameter for the result
+     * @return std::string empty on success, the error message otherwise
+     */
+    std::string process(const std::vector<std::string> &args, std::string &result);
+
+    std::string socket_path;
+    ThreadPool pool;
+    OutputImage output_image;
+};
+
+#endif // ASCII_ART_SERVER_HPP
@@ -0,0 +1,185 @@
+#include "SlideCache.hpp"
+#include "Output.hpp"
+#include "TextRasterizer.hpp"
+#include "Trace.hpp"
+
+SlideCache::SlideCache(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, const char *font_path, size_t memory_limit)
+    : images(images), font_path(font_path), memory_limit(memory_limit), slides(images.size()), clock(0), closing(false), prefetcher(2)
+{
+    // the luma plane holds the gray directly, 0 is black and 255 white
+    SDL_SetYUVConversionMode(SDL_YUV_CONVERSION_JPEG);
+}
+
+SlideCache::~SlideCache()
+{
+    closing = true;
+    std::lock_guard<std::mutex> guard(lock);
+    for (Slide &slide : slides)
+    {
+        if (slide.texture)
+        {
+            SDL_DestroyTexture(slide.texture);
+            slide.texture = nullptr;
+        }
+    }
+}
+
+SDL_Texture *SlideCache::texture(SDL_Renderer *renderer, size_t index)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    Slide &slide = slides[index];
+    slide.last_used = ++clock;
+
+    if (slide.state == State::Empty)
+    { // not prefetched, rendered right here
+        slide.state = State::Rendering;
+        GlyphAtlas *slide_atlas = atlas(index);
+        guard.unlock();
+        Slide result;
+        render(index, slide_atlas, result);
+        guard.lock();
+        slide.pixels = std::move(result.pixels);
+        slide.width = result.width;
+        slide.height = result.height;
+        slide.state = State::Rendered;
+    }
+    rendered.wait(guard, [&slide]
+                  { return slide.state != State::Rendering; });
+
+    if (slide.state == State::Rendered)
+    {
+        Trace::Span span("SlideCache::upload");
+        if (!slide.pixels.empty())
+        {
+            slide.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_IYUV, SDL_TEXTUREACCESS_STATIC, slide.width, slide.height);
+        }
+        if (slide.texture)
+        {
+            // the slides are gray, the chroma planes are neutral
+            int chroma_pitch = (slide.width + 1) / 2;
+            std::vector<unsigned char> chroma(static_cast<size_t>(chroma_pitch) * ((slide.height + 1) / 2), 128);
+            SDL_UpdateYUVTexture(slide.texture, nullptr, slide.pixels.data(), slide.width,
+                                 chroma.data(), chroma_pitch, chroma.data(), chroma_pitch);
+        }
+        std::vector<unsigned char>().swap(slide.pixels);
+        slide.state = slide.texture ? State::Uploaded : State::Empty;
+    }
+
+    if (slides.size() > 1)
+    {
+        prefetch((index + 1) % slides.size());
+        prefetch((index + slides.size() - 1) % slides.size());
+    }
+    evict(index);
+    return slide.texture;
+}
+
+size_t SlideCache::size() const
+{
+    return slides.size();
+}
+
+GlyphAtlas *SlideCache::atlas(size_t index) const
+{
+    const auto &image = images[index];
+    // Due to old ProgTest library version, I am unable to use TTF_SetFontSize, the atlas keeps one font per size
+    return GlyphAtlas::get(font_path, Output::fontSize(*image.first, image.second));
+}
+
+void SlideCache::render(size_t index, GlyphAtlas *atlas, Slide &slide) const
+{
+    const auto &image = images[index];
+    if (!atlas)
+    {
+        return;
+    }
+
+    Trace::Span span("SlideCache::render", image.second.image_path, image.second.scale);
+    TextRasterizer rasterizer(*atlas, *image.first, Output::fontSize(*image.first, image.second));
+    slide.width = rasterizer.width();
+    slide.height = rasterizer.height();
+    span.setSize(slide.width, slide.height);
+    if (slide.width == 0 || slide.height == 0)
+    {
+        return;
+    }
+    slide.pixels.resize(static_cast<size_t>(slide.width) * slide.height);
+    rasterizer.renderRows(0, slide.height, slide.pixels.data());
+}
+
+void SlideCache::prefetch(size_t index)
+{
+    if (slides[index].state != State::Empty)
+    {
+        return;
+    }
+    slides[index].state = State::Rendering;
+    GlyphAtlas *slide_atlas = atlas(index);
+    prefetcher.submit([this, index, slide_atlas]
+                      {
+        Slide result;
+        if (!closing)
+        {
+            render(index, slide_atlas, result);
+        }
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            Slide &slide = slides[index];
+            slide.pixels = std::move(result.pixels);
+            slide.width = result.width;
+            slide.height = result.height;
+            slide.state = State::Rendered;
+        }
+        rendered.notify_all(); });
+}
+
+void SlideCache::evict(size_t current)
+{
+    size_t used = 0;
+    for (const Slide &slide : slides)
+    {
+        used += memory(slide);
+    }
+
+    while (used > memory_limit)
+    {
+        Slide *oldest = nullptr;
+        for (size_t i = 0; i < slides.size(); ++i)
+        {
+            Slide &slide = slides[i];
+            bool droppable = slide.state == State::Rendered || slide.state == State::Uploaded;
+            if (droppable && !isNeighbour(i, current) && (!oldest || slide.last_used < oldest->last_used))
+            {
+                oldest = &slide;
+            }
+        }
+        if (!oldest)
+        { // only the current slide and its neighbours are left
+            return;
+        }
+
+        used -= memory(*oldest);
+        if (oldest->texture)
+        {
+            SDL_DestroyTexture(oldest->texture);
+            oldest->texture = nullptr;
+        }
+        std::vector<unsigned char>().swap(oldest->pixels);
+        oldest->state = State::Empty;
+    }
+}
+
+bool SlideCache::isNeighbour(size_t index, size_t current) const
+{
+    size_t count = slides.size();
+    return index == current || index == (current + 1) % count || index == (current + count - 1) % count;
+}
+
+size_t SlideCache::memory(const Slide &slide)
+{
+    if (slide.texture)
+    { // luma plane and two quarter size chroma planes
+        return static_cast<size_t>(slide.width) * slide.height * 3 / 2;
+    }
+    return slide.pixels.size();
+}
@@ -0,0 +1,137 @@
+#ifndef ASCII_ART_SLIDECACHE_HPP
+#define ASCII_ART_SLIDECACHE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "GlyphAtlas.hpp"
+#include "Image.hpp"
+#include "ImgOptions.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * @brief Textures of the slides of the presentation, rendered on demand and kept under a memory limit
+ *
+ * @details A slide is rendered (TextRasterizer) when it is shown for the first time, the neighbouring slides are
+ * rendered in the background meanwhile, so moving to the next or previous slide does not wait. Only the rendered pixels
+ * are prepared in the background, the textures are created on the thread of the renderer.
+ *
+ * The slides are uploaded as grayscale: the luma plane of an IYUV texture (1.5 bytes per pixel instead of 3 of RGB24).
+ * When the textures and the prefetched pixels exceed the memory limit, the least recently shown slides are dropped
+ * (never the current slide and its neighbours) and rendered again if they are needed later.
+ */
+class SlideCache
+{
+public:
+    /**
+     * @brief Default limit of the memory of the textures and prefetched slides in bytes
+     */
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = 512ull * 1024 * 1024;
+
+    /**
+     * @brief Construct a new SlideCache, nothing is rendered yet
+     * @param images The images with the converted ascii images, must outlive the cache
+     * @param font_path Path to the font the slides are rendered with
+     * @param memory_limit Limit of the memory of the textures and prefetched slides in bytes
+     */
+    SlideCache(const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images, const char *font_path, size_t memory_limit = DEFAULT_MEMORY_LIMIT);
+
+    /**
+     * @brief Destroy the textures, the background rendering is finished first
+     */
+    ~SlideCache();
+
+    SlideCache(const SlideCache &) = delete;
+    SlideCache &operator=(const SlideCache &) = delete;
+
+    /**
+     * @brief Get the texture of the slide and start prefetching its neighbours, called from the thread of the renderer
+     * @param renderer Renderer the texture is used with
+     * @param index Index of the slide
+     * @return SDL_Texture* the texture (owned by the cache, valid until the next call), nullptr on failure
+     */
+    SDL_Texture *texture(SDL_Renderer *renderer, size_t index);
+
+    /**
+     * @brief Get the number of slides
+     * @return size_t number of slides
+     */
+    size_t size() const;
+
+private:
+    enum class State
+    {
+        Empty,
+        Rendering,
+        Rendered,
+        Uploaded
+    };
+
+    struct Slide
+    {
+        State state = State::Empty;
+        std::vector<unsigned char> pixels;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        SDL_Texture *texture = nullptr;
+        uint64_t last_used = 0;
+    };
+
+    /**
+     * @brief Get the atlas for the slide, the fonts are opened on the thread of the renderer only
+     * @param index Index of the slide
+     * @return GlyphAtlas* the atlas, nullptr if the font can't be opened
+     */
+    GlyphAtlas *atlas(size_t index) const;
+
+    /**
+     * @brief Render the pixels of the slide, safe to call from any thread
+     * @param index Index of the slide
+     * @param atlas The atlas of the slide
+     * @param slide Output parameter for the pixels and the dimensions
+     */
+    void render(size_t index, GlyphAtlas *atlas, Slide &slide) const;
+
+    /**
+     * @brief Start rendering the slide in the background if it is not rendered yet, the lock must be held
+     * @param index Index of the slide
+     */
+    void prefetch(size_t index);
+
+    /**
+     * @brief Drop the least recently shown slides until the memory limit is kept, the lock must be held
+     * @param current Index of the current slide, it and its neighbours are kept
+     */
+    void evict(size_t current);
+
+    /**
+     * @brief Check whether the slide is the current one or one of its neighbours
+     */
+    bool isNeighbour(size_t index, size_t current) const;
+
+    /**
+     * @brief Get the memory used by the slide (texture or prefetched pixels)
+     */
+    static size_t memory(const Slide &slide);
+
+    const std::vector<std::pair<std::unique_ptr<Image>, Img>> &images;
+    const char *font_path;
+    size_t memory_limit;
+
+    std::vector<Slide> slides;
+    uint64_t clock;
+    std::mutex lock;
+    std::condition_variable rendered;
+    std::atomic<bool> closing;
+
+    /**
+     * @brief Single background thread rendering the neighbouring slides, destroyed (joined) first
+     */
+    ThreadPool prefetcher;
+};
+
+#endif // ASCII_ART_SLIDECACHE_HPP
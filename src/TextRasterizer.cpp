@@ -0,0 +1,83 @@
+#include "TextRasterizer.hpp"
+#include <algorithm>
+#include <cstring>
+
+TextRasterizer::TextRasterizer(GlyphAtlas &atlas, const Image &image, int font_size)
+    : image(image), font_size(font_size), cell_height(atlas.cellHeight())
+{
+    std::array<bool, 256> used{};
+    for (unsigned char glyph : image.ascii_image)
+    {
+        used[glyph] = true;
+    }
+    used['\n'] = false;
+
+    const int cell_width = atlas.cellWidth();
+    for (int glyph = 0; glyph < 256; ++glyph)
+    {
+        if (!used[glyph])
+        {
+            continue;
+        }
+        const unsigned char *bitmap = atlas.bitmap(glyph);
+        if (std::all_of(bitmap, bitmap + cell_width * cell_height, [](unsigned char a)
+                        { return a == 0; }))
+        {
+            continue;
+        }
+
+        // nearest neighbour, sampled in the centers of the pixels like the renderer does
+        std::vector<unsigned char> &stretched = glyphs[glyph];
+        stretched.resize(static_cast<size_t>(font_size) * cell_height);
+        for (int y = 0; y < cell_height; ++y)
+        {
+            for (int x = 0; x < font_size; ++x)
+            {
+                stretched[y * font_size + x] = bitmap[y * cell_width + (2 * x + 1) * cell_width / (2 * font_size)];
+            }
+        }
+    }
+}
+
+unsigned int TextRasterizer::width() const
+{
+    return image.ascii_width * font_size;
+}
+
+unsigned int TextRasterizer::height() const
+{
+    return image.ascii_height * font_size;
+}
+
+void TextRasterizer::renderRows(unsigned int first_row, unsigned int last_row, unsigned char *out) const
+{
+    const size_t row_length = width();
+    const size_t line_length = image.ascii_width + 1;
+    std::memset(out, 0, (last_row - first_row) * row_length);
+
+    for (unsigned int row = first_row; row < last_row; ++row, out += row_length)
+    {
+        // glyphs taller than the line reach into the following lines, later lines are blended over them
+        unsigned int first_line = row < static_cast<unsigned int>(cell_height) ? 0 : (row - cell_height) / font_size + 1;
+        unsigned int last_line = std::min(row / font_size + 1, image.ascii_height);
+        for (unsigned int line = first_line; line < last_line; ++line)
+        {
+            const char *text = image.ascii_image.data() + line * line_length;
+            size_t glyph_row = (row - line * font_size) * font_size;
+            for (unsigned int column = 0; column < image.ascii_width; ++column)
+            {
+                const std::vector<unsigned char> &glyph = glyphs[static_cast<unsigned char>(text[column])];
+                if (glyph.empty())
+                {
+                    continue;
+                }
+                const unsigned char *coverage = glyph.data() + glyph_row;
+                unsigned char *pixel = out + column * font_size;
+                for (int x = 0; x < font_size; ++x)
+                { // white over the current pixel
+                    pixel[x] = (255 * coverage[x] + pixel[x] * (255 - coverage[x]) + 127) / 255;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef ASCII_ART_TEXTRASTERIZER_HPP
+#define ASCII_ART_TEXTRASTERIZER_HPP
+
+#include <array>
+#include <vector>
+#include "GlyphAtlas.hpp"
+#include "Image.hpp"
+
+/**
+ * @brief Software renderer of the ascii image to an 8-bit grayscale bitmap (white text on black background)
+ *
+ * @details The glyph bitmaps from the GlyphAtlas are stretched to the cells of the image once, then the pixel rows are composed
+ * on the CPU without any renderer or display. Any range of rows can be rendered independently, so the image can be
+ * rendered in bands in parallel and written out while the rest of it is not rendered yet.
+ * The result is the same as the one of Image::createTexture (glyphs blended over each other in the order of the lines).
+ */
+class TextRasterizer
+{
+public:
+    /**
+     * @brief Construct a new TextRasterizer and prepare the glyphs used by the image
+     * @param atlas Glyphs of the font the text is rendered with
+     * @param image The image with the converted ascii image
+     * @param font_size Size of the cell of one character in pixels
+     */
+    TextRasterizer(GlyphAtlas &atlas, const Image &image, int font_size);
+
+    /**
+     * @brief Get the width of the rendered image
+     * @return unsigned int width in pixels
+     */
+    unsigned int width() const;
+
+    /**
+     * @brief Get the height of the rendered image
+     * @return unsigned int height in pixels
+     */
+    unsigned int height() const;
+
+    /**
+     * @brief Render the pixel rows [first_row, last_row), safe to call from multiple threads at once
+     * @param first_row Index of the first rendered row
+     * @param last_row Index of the row after the last rendered one
+     * @param out Buffer for (last_row - first_row) * width() pixels
+     */
+    void renderRows(unsigned int first_row, unsigned int last_row, unsigned char *out) const;
+
+private:
+    const Image &image;
+    int font_size;
+    int cell_height;
+
+    /**
+     * @brief Coverage of the glyphs used by the image stretched to font_size x cell_height, empty for blank glyphs
+     */
+    std::array<std::vector<unsigned char>, 256> glyphs;
+};
+
+#endif // ASCII_ART_TEXTRASTERIZER_HPP
@@ -0,0 +1,179 @@
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t threads) : pending(0), queued(0), next_queue(0), stopping(false)
+{
+    if (threads == 0)
+    {
+        threads = defaultThreads();
+    }
+
+    for (size_t i = 0; i < threads; ++i)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i + 1 < threads; ++i)
+    { // the last queue belongs to the thread calling wait()
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    try
+    {
+        wait();
+    }
+    catch (...)
+    { // nobody is left to report the error to
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    size_t index = next_queue++ % queues.size();
+    pending++;
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+        queued++;
+    }
+    {
+        // sleeping threads check their predicates under this lock, taking it here means no wake up gets lost
+        std::lock_guard<std::mutex> guard(sleep_lock);
+    }
+    wake.notify_one();
+    finished.notify_all();
+}
+
+void ThreadPool::wait()
+{
+    std::function<void()> task;
+    size_t index = queues.size() - 1;
+    while (pending > 0)
+    {
+        if (takeTask(index, task))
+        {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        finished.wait(guard, [this]
+                      { return pending == 0 || queued > 0; });
+    }
+
+    std::exception_ptr failure;
+    {
+        std::lock_guard<std::mutex> guard(error_lock);
+        std::swap(failure, error);
+    }
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+size_t ThreadPool::size() const
+{
+    return queues.size();
+}
+
+size_t ThreadPool::defaultThreads()
+{
+    size_t threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+    std::function<void()> task;
+    while (true)
+    {
+        if (takeTask(index, task))
+        {
+            runTask(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        wake.wait(guard, [this]
+                  { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::takeTask(size_t index, std::function<void()> &task)
+{
+    if (queued == 0)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < queues.size(); ++i)
+    {
+        Queue &queue = *queues[(index + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.tasks.empty())
+        {
+            continue;
+        }
+
+        if (i == 0)
+        { // own queue - newest task first
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+        else
+        { // stealing - oldest task first
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::runTask(std::function<void()> &task)
+{
+    // the task is counted as finished however it ends, otherwise wait() would never return
+    struct Finish
+    {
+        ThreadPool &pool;
+        std::function<void()> &task;
+        ~Finish()
+        {
+            task = nullptr;
+            if (--pool.pending == 0)
+            {
+                std::lock_guard<std::mutex> guard(pool.sleep_lock);
+                pool.finished.notify_all();
+            }
+        }
+    } finish{*this, task};
+
+    try
+    {
+        task();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> guard(error_lock);
+        if (!error)
+        {
+            error = std::current_exception();
+        }
+    }
+}
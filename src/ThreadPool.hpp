@@ -0,0 +1,120 @@
+#ifndef ASCII_ART_THREADPOOL_HPP
+#define ASCII_ART_THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Work-stealing thread pool used to process images (and parts of them) in parallel
+ *
+ * @details Every worker owns a task deque. Tasks are pushed round-robin to the workers, a worker pops from the back
+ * of its own deque and when it runs dry it steals from the front of the other deques.
+ * The thread calling wait() does not idle either, it owns the last queue and runs queued tasks until everything is done.
+ * An exception thrown by a task doesn't stop the pool, the first one is kept and rethrown by wait().
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Construct a new ThreadPool and start the worker threads
+     * @param threads Number of threads working on the tasks including the thread calling wait(), 0 means ThreadPool::defaultThreads()
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    /**
+     * @brief Finish the queued tasks and join the worker threads
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queue a task for execution
+     * @param task The task to run
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Block until all submitted tasks are finished, the calling thread helps with the queued tasks meanwhile
+     * @throw the first exception thrown by the tasks since the last wait()
+     */
+    void wait();
+
+    /**
+     * @brief Get the number of threads working on the tasks (including the thread calling wait())
+     * @return size_t number of threads
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the number of hardware threads, at least 1
+     * @return size_t default number of threads
+     */
+    static size_t defaultThreads();
+
+private:
+    /**
+     * @brief Task deque of a single worker
+     */
+    struct Queue
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    /**
+     * @brief Main loop of the worker thread
+     * @param index Index of the worker (and of its own queue)
+     */
+    void workerLoop(size_t index);
+
+    /**
+     * @brief Take a task from the own queue or steal one from the others
+     * @param index Index of the queue to look into first
+     * @param task Output parameter for the task
+     * @return true if a task was found
+     */
+    bool takeTask(size_t index, std::function<void()> &task);
+
+    /**
+     * @brief Run the task and signal waiters if it was the last pending one, also if the task throws
+     * @param task The task to run
+     */
+    void runTask(std::function<void()> &task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    /**
+     * @brief Number of submitted tasks which did not finish yet
+     */
+    std::atomic<size_t> pending;
+
+    /**
+     * @brief Number of tasks waiting in the queues
+     */
+    std::atomic<size_t> queued;
+
+    /**
+     * @brief First exception thrown by a task, rethrown by wait()
+     */
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    std::atomic<size_t> next_queue;
+    std::atomic<bool> stopping;
+};
+
+#endif // ASCII_ART_THREADPOOL_HPP
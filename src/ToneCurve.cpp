@@ -0,0 +1,65 @@
+#include "ToneCurve.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    unsigned char clamp(double value)
+    {
+        return static_cast<unsigned char>(std::min(std::max(std::lround(value), 0l), 255l));
+    }
+
+    unsigned char applyOperation(const ToneOp &operation, unsigned char gray)
+    {
+        switch (operation.kind)
+        {
+        case ToneOp::Kind::Contrast:
+            return clamp((gray - 128.0) * operation.first + 128.0);
+        case ToneOp::Kind::Gamma:
+            return clamp(255.0 * std::pow(gray / 255.0, 1.0 / operation.first));
+        case ToneOp::Kind::Levels:
+            return clamp((gray - operation.first) * 255.0 / (operation.second - operation.first));
+        case ToneOp::Kind::Threshold:
+            return gray >= operation.first ? 255 : 0;
+        case ToneOp::Kind::Posterize:
+        {
+            const double steps = operation.first - 1;
+            return clamp(std::round(gray * steps / 255.0) * 255.0 / steps);
+        }
+        case ToneOp::Kind::Negate:
+            return 255 - gray;
+        }
+        return gray;
+    }
+}
+
+ToneCurve::ToneCurve(const std::vector<ToneOp> &operations) : ToneCurve(operations.begin(), operations.end())
+{
+}
+
+ToneCurve::ToneCurve(std::vector<ToneOp>::const_iterator first, std::vector<ToneOp>::const_iterator last)
+{
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        levels[gray] = gray;
+    }
+    for (; first != last; ++first)
+    {
+        for (unsigned char &level : levels)
+        {
+            level = applyOperation(*first, level);
+        }
+    }
+}
+
+bool ToneCurve::identity() const
+{
+    for (int gray = 0; gray < 256; ++gray)
+    {
+        if (levels[gray] != gray)
+        {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef ASCII_ART_TONECURVE_HPP
+#define ASCII_ART_TONECURVE_HPP
+
+#include <array>
+#include <vector>
+#include "ImgOptions.hpp"
+
+/**
+ * @brief Lookup table of a chain of point operations (contrast, gamma, levels, threshold, posterize, negate)
+ *
+ * @details Every operation maps a gray level to a gray level, so the whole chain is composed into a single table of
+ * 256 entries when it is built. The operations are composed on 8-bit levels, the result is the same as applying them
+ * one after another to the pixels, but the pixels are looked up just once however long the chain is.
+ * The converter fuses the table with the glyph table (or with the summed-area table of the area sampling),
+ * so the chain costs no pass over the pixels at all.
+ */
+class ToneCurve
+{
+public:
+    /**
+     * @brief Compose the operations to the table
+     * @param operations The operations in the order they are applied
+     */
+    explicit ToneCurve(const std::vector<ToneOp> &operations);
+
+    /**
+     * @brief Compose the operations [first, last) to the table
+     */
+    ToneCurve(std::vector<ToneOp>::const_iterator first, std::vector<ToneOp>::const_iterator last);
+
+    /**
+     * @brief Get the gray level the chain maps the gray level to
+     */
+    unsigned char operator[](unsigned char gray) const
+    {
+        return levels[gray];
+    }
+
+    /**
+     * @brief Get whether the chain keeps every gray level (no operations or operations cancelling each other)
+     */
+    bool identity() const;
+
+private:
+    std::array<unsigned char, 256> levels;
+};
+
+#endif // ASCII_ART_TONECURVE_HPP
@@ -0,0 +1,149 @@
+#include "Trace.hpp"
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    /**
+     * @brief Complete event ("ph": "X") of the trace
+     */
+    struct Event
+    {
+        const char *name;
+        long long start_us;
+        long long duration_us;
+        unsigned int thread;
+        std::string image;
+        double scale;
+        unsigned int width;
+        unsigned int height;
+    };
+
+    std::atomic<bool> tracing(false);
+    std::mutex events_lock;
+    std::vector<Event> events;
+    std::string trace_path;
+    std::chrono::steady_clock::time_point trace_start;
+
+    /**
+     * @brief Small sequential id of the calling thread, easier to read in the viewer than std::thread::id
+     */
+    unsigned int threadId()
+    {
+        static std::atomic<unsigned int> next_id(1);
+        thread_local unsigned int id = next_id++;
+        return id;
+    }
+}
+
+void Trace::enable(const std::string &path)
+{
+    std::lock_guard<std::mutex> guard(events_lock);
+    trace_path = path;
+    events.clear();
+    trace_start = std::chrono::steady_clock::now();
+    tracing = true;
+}
+
+bool Trace::enabled()
+{
+    return tracing.load(std::memory_order_relaxed);
+}
+
+bool Trace::write()
+{
+    if (!tracing.exchange(false))
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> guard(events_lock);
+    std::ofstream file(trace_path);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    file << "{\"traceEvents\": [\n";
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        const Event &e = events[i];
+        file << "  {\"name\": \"" << e.name << "\", \"cat\": \"ascii-art\", \"ph\": \"X\", \"ts\": " << e.start_us
+             << ", \"dur\": " << e.duration_us << ", \"pid\": 1, \"tid\": " << e.thread << ", \"args\": {";
+        if (!e.image.empty())
+        {
+            file << "\"image\": " << jsonString(e.image) << ", \"scale\": " << e.scale;
+            if (e.width || e.height)
+            {
+                file << ", \"width\": " << e.width << ", \"height\": " << e.height;
+            }
+        }
+        file << "}}" << (i + 1 < events.size() ? "," : "") << "\n";
+    }
+    file << "], \"displayTimeUnit\": \"ms\"}\n";
+    events.clear();
+    return file.good();
+}
+
+std::string Trace::jsonString(const std::string &text)
+{
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    std::string escaped = "\"";
+    for (char c : text)
+    {
+        const unsigned char byte = static_cast<unsigned char>(c);
+        if (byte < 0x20)
+        { // control characters are not allowed in the strings of JSON
+            escaped += "\\u00";
+            escaped += HEX_DIGITS[byte >> 4];
+            escaped += HEX_DIGITS[byte & 0xF];
+            continue;
+        }
+        if (c == '"' || c == '\\')
+        {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+Trace::Span::Span(const char *name) : name(name), active(Trace::enabled()), scale(0), width(0), height(0)
+{
+    if (active)
+    {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+Trace::Span::Span(const char *name, const std::string &image, double scale) : Span(name)
+{
+    if (active)
+    {
+        this->image = image;
+        this->scale = scale;
+    }
+}
+
+Trace::Span::~Span()
+{
+    if (!active || !Trace::enabled())
+    {
+        return;
+    }
+    auto end = std::chrono::steady_clock::now();
+    unsigned int thread = threadId();
+
+    std::lock_guard<std::mutex> guard(events_lock);
+    long long start_us = std::chrono::duration_cast<std::chrono::microseconds>(start - trace_start).count();
+    long long duration_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    events.push_back({name, start_us, duration_us, thread, std::move(image), scale, width, height});
+}
+
+void Trace::Span::setSize(unsigned int width, unsigned int height)
+{
+    this->width = width;
+    this->height = height;
+}
@@ -0,0 +1,88 @@
+#ifndef ASCII_ART_TRACE_HPP
+#define ASCII_ART_TRACE_HPP
+
+#include <chrono>
+#include <string>
+
+/**
+ * @brief Timeline of the processing in the Chrome trace-event format (chrome://tracing, Perfetto)
+ *
+ * @details Stages are recorded as spans (Trace::Span) with the thread, the image path, its dimensions and scale.
+ * The events are collected in memory and written by Trace::write at the end.
+ * While tracing is not enabled a span only checks a flag, so the spans stay compiled in.
+ */
+class Trace
+{
+public:
+    /**
+     * @brief Start recording the spans
+     * @param path Path to the file the trace is written to
+     */
+    static void enable(const std::string &path);
+
+    /**
+     * @brief Check whether the spans are recorded
+     * @return true if tracing is enabled
+     */
+    static bool enabled();
+
+    /**
+     * @brief Write the recorded events to the trace file and stop recording
+     * @return true if the file was written successfully (or tracing was not enabled)
+     */
+    static bool write();
+
+    /**
+     * @brief Quote the text as a JSON string, the quotes, backslashes and control characters are escaped
+     * @param text The text, e.g. a path
+     * @return The quoted text
+     */
+    static std::string jsonString(const std::string &text);
+
+    /**
+     * @brief Span of a stage, measured from the construction to the destruction
+     */
+    class Span
+    {
+    public:
+        /**
+         * @brief Start the span
+         * @param name Name of the stage, must outlive the span (string literal)
+         */
+        explicit Span(const char *name);
+
+        /**
+         * @brief Start the span of a stage processing an image
+         * @param name Name of the stage, must outlive the span (string literal)
+         * @param image Path to the image
+         * @param scale Scale of the image
+         */
+        Span(const char *name, const std::string &image, double scale);
+
+        /**
+         * @brief End the span and record it
+         */
+        ~Span();
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+
+        /**
+         * @brief Set the dimensions of the image, usually known only after decoding
+         * @param width Width of the image
+         * @param height Height of the image
+         */
+        void setSize(unsigned int width, unsigned int height);
+
+    private:
+        const char *name;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+        std::string image;
+        double scale;
+        unsigned int width;
+        unsigned int height;
+    };
+};
+
+#endif // ASCII_ART_TRACE_HPP
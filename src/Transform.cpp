@@ -0,0 +1,162 @@
+#include "Transform.hpp"
+#include <algorithm>
+#include "BufferPool.hpp"
+
+Transform::Transform(unsigned int width, unsigned int height, const Img &img, double scaleFactor)
+    : source_width(width), swap_axes(img.rotate == 90 || img.rotate == 270),
+      // whether the rotated axis runs against the source axis, the flip mirrors it once more
+      columns_mirrored((img.rotate == 90 || img.rotate == 180) != img.flip_horizontal),
+      lines_mirrored((img.rotate == 180 || img.rotate == 270) != img.flip_vertical)
+{
+    const size_t w = width, h = height;
+    size_t rotated_width = swap_axes ? h : w;
+    size_t rotated_height = swap_axes ? w : h;
+
+    // samples of a cell across the lines per samples of a cell along them, the lines are sampled this much sparser
+    const double cell_aspect = img.cell_aspect > 0 ? img.cell_aspect : 1.0;
+    const double lines_ratio = cell_aspect * cellRows(img.cells) / cellColumns(img.cells);
+    double scale_x = scaleFactor;
+    int scaledWidth, scaledHeight;
+    if (img.columns > 0 || img.lines > 0)
+    { // the largest scale the image fits to both targets at, the axis that decides gets exactly its target
+        const double fit_x = img.columns > 0 ? static_cast<double>(img.columns) * cellColumns(img.cells) / rotated_width : 0;
+        const double fit_y = img.lines > 0 ? static_cast<double>(img.lines) * cellRows(img.cells) / (rotated_height * lines_ratio) : 0;
+        const bool by_columns = fit_y == 0 || (fit_x > 0 && fit_x <= fit_y);
+        scale_x = by_columns ? fit_x : fit_y;
+        scaledWidth = by_columns ? img.columns * cellColumns(img.cells) : std::max(static_cast<int>(rotated_width * scale_x), 1);
+        scaledHeight = by_columns ? std::max(static_cast<int>(rotated_height * scale_x * lines_ratio), 1) : img.lines * cellRows(img.cells);
+    }
+    else
+    {
+        scaledWidth = rotated_width * scale_x;
+        scaledHeight = rotated_height * scale_x * lines_ratio;
+    }
+    const double scale_y = scale_x * lines_ratio;
+    column_offsets = BufferPool<size_t>::shared().acquire(std::max(scaledWidth, 0));
+    line_offsets = BufferPool<size_t>::shared().acquire(std::max(scaledHeight, 0));
+    column_spans = BufferPool<Span>::shared().acquire(column_offsets.size());
+    line_spans = BufferPool<Span>::shared().acquire(line_offsets.size());
+
+    // offset of the source pixel for the column X and for the line Y of the rotated image
+    auto column = [&](size_t X) -> size_t
+    {
+        switch (img.rotate)
+        {
+        case 90:
+            return (h - 1 - X) * w;
+        case 180:
+            return w - 1 - X;
+        case 270:
+            return X * w;
+        default:
+            return X;
+        }
+    };
+    auto line = [&](size_t Y) -> size_t
+    {
+        switch (img.rotate)
+        {
+        case 90:
+            return Y;
+        case 180:
+            return (h - 1 - Y) * w;
+        case 270:
+            return w - 1 - Y;
+        default:
+            return Y * w;
+        }
+    };
+
+    // the cell covers [first, last) of the rotated image, mirrored back to the source axis if the axis runs backwards
+    auto span = [&](int i, size_t length, double scale, bool mirrored) -> Span
+    {
+        size_t first = std::min(static_cast<size_t>(i / scale), length - 1);
+        size_t last = std::min(std::max(static_cast<size_t>((i + 1) / scale), first + 1), length);
+        if (mirrored)
+        {
+            return {static_cast<unsigned int>(length - last), static_cast<unsigned int>(length - first)};
+        }
+        return {static_cast<unsigned int>(first), static_cast<unsigned int>(last)};
+    };
+    for (int x = 0; x < scaledWidth; ++x)
+    {
+        size_t X = std::min<size_t>(static_cast<int>(x / scale_x), rotated_width - 1);
+        column_offsets[x] = column(img.flip_horizontal ? rotated_width - 1 - X : X);
+        column_spans[x] = span(x, rotated_width, scale_x, columns_mirrored);
+    }
+    for (int y = 0; y < scaledHeight; ++y)
+    {
+        size_t Y = std::min<size_t>(static_cast<int>(y / scale_y), rotated_height - 1);
+        line_offsets[y] = line(img.flip_vertical ? rotated_height - 1 - Y : Y);
+        line_spans[y] = span(y, rotated_height, scale_y, lines_mirrored);
+    }
+}
+
+Transform::~Transform()
+{
+    BufferPool<size_t>::shared().release(std::move(column_offsets));
+    BufferPool<size_t>::shared().release(std::move(line_offsets));
+    BufferPool<Span>::shared().release(std::move(column_spans));
+    BufferPool<Span>::shared().release(std::move(line_spans));
+}
+
+bool Transform::isRowLocal(const Img &img)
+{
+    // upside down rotation flipped vertically back is only a horizontal flip
+    return (img.rotate == 0 && !img.flip_vertical) || (img.rotate == 180 && img.flip_vertical);
+}
+
+unsigned int Transform::columns() const
+{
+    return column_offsets.size();
+}
+
+unsigned int Transform::lines() const
+{
+    return line_offsets.size();
+}
+
+const std::vector<size_t> &Transform::columnOffsets() const
+{
+    return column_offsets;
+}
+
+const std::vector<size_t> &Transform::lineOffsets() const
+{
+    return line_offsets;
+}
+
+unsigned int Transform::sourceRow(unsigned int line) const
+{
+    return line_offsets[line] / source_width;
+}
+
+const std::vector<Transform::Span> &Transform::columnSpans() const
+{
+    return column_spans;
+}
+
+const std::vector<Transform::Span> &Transform::lineSpans() const
+{
+    return line_spans;
+}
+
+bool Transform::swapsAxes() const
+{
+    return swap_axes;
+}
+
+bool Transform::columnsMirrored() const
+{
+    return columns_mirrored;
+}
+
+bool Transform::linesMirrored() const
+{
+    return lines_mirrored;
+}
+
+unsigned int Transform::width() const
+{
+    return source_width;
+}
@@ -0,0 +1,135 @@
+#ifndef ASCII_ART_TRANSFORM_HPP
+#define ASCII_ART_TRANSFORM_HPP
+
+#include <vector>
+#include "ImgOptions.hpp"
+
+/**
+ * @brief Geometric transformation (rotation, flips and scale) mapping every output cell to a pixel of the decoded image
+ *
+ * @details Rotations by multiples of 90 degrees and flips only swap and mirror the axes, so the source pixel of the cell
+ * [x, y] is always line_offsets[y] + column_offsets[x]. The offsets are computed once, the image is never rotated or flipped
+ * in memory and no intermediate image is created.
+ *
+ * The result is the same as rotating the image first, then flipping it horizontally and vertically and sampling it last.
+ *
+ * The axes are sampled with independent steps: the lines step is the columns step divided by the cell aspect (width / height
+ * of an output cell) and adjusted by the samples per cell, so the image keeps its proportions in the non-square cells.
+ * If the image is fitted to a number of columns or lines, the steps are derived from the target instead of the scale.
+ */
+class Transform
+{
+public:
+    /**
+     * @brief Construct a new Transform
+     * @param width Width of the decoded image
+     * @param height Height of the decoded image
+     * @param img Configuration of the image (rotate, flip_horizontal, flip_vertical, columns, lines, cell_aspect, cells)
+     * @param scaleFactor The scale factor to apply to the width of the (rotated) image, ignored if the image is fitted to a target
+     */
+    Transform(unsigned int width, unsigned int height, const Img &img, double scaleFactor);
+
+    /**
+     * @brief Destroy the Transform, the offsets and the spans are returned to the buffer pool
+     */
+    ~Transform();
+
+    Transform(const Transform &) = delete;
+    Transform &operator=(const Transform &) = delete;
+
+    /**
+     * @brief Check whether every output line reads a single source row and the rows are read from top to bottom,
+     * i.e. whether the image can be converted while it is being decoded
+     * @param img Configuration of the image
+     * @return true if the image can be converted row by row
+     */
+    static bool isRowLocal(const Img &img);
+
+    /**
+     * @brief Get the number of output columns
+     * @return unsigned int number of columns
+     */
+    unsigned int columns() const;
+
+    /**
+     * @brief Get the number of output lines
+     * @return unsigned int number of lines
+     */
+    unsigned int lines() const;
+
+    /**
+     * @brief Get the offset of the source pixel of every column relative to the line offset
+     * @return const std::vector<size_t>& column offsets
+     */
+    const std::vector<size_t> &columnOffsets() const;
+
+    /**
+     * @brief Get the offset of the first source pixel of every line
+     * @return const std::vector<size_t>& line offsets
+     */
+    const std::vector<size_t> &lineOffsets() const;
+
+    /**
+     * @brief Get the source row of the line, meaningful only if the transform is row local
+     * @param line Index of the output line
+     * @return unsigned int index of the source row
+     */
+    unsigned int sourceRow(unsigned int line) const;
+
+    /**
+     * @brief Range [first, last) of the source pixels along one axis of the decoded image
+     */
+    struct Span
+    {
+        unsigned int first;
+        unsigned int last;
+    };
+
+    /**
+     * @brief Get the range of the source pixels covered by every column, used by the area sampling and the shape matching
+     * @return const std::vector<Span>& source columns (rows if swapsAxes()) of every output column
+     */
+    const std::vector<Span> &columnSpans() const;
+
+    /**
+     * @brief Get the range of the source pixels covered by every line, used by the area sampling and the shape matching
+     * @return const std::vector<Span>& source rows (columns if swapsAxes()) of every output line
+     */
+    const std::vector<Span> &lineSpans() const;
+
+    /**
+     * @brief Check whether the output columns go along the source rows (rotation by 90 or 270 degrees)
+     * @return true if the axes are swapped
+     */
+    bool swapsAxes() const;
+
+    /**
+     * @brief Check whether the output columns go against the source axis they run along (right to left or bottom to top)
+     * @return true if the columns are mirrored
+     */
+    bool columnsMirrored() const;
+
+    /**
+     * @brief Check whether the output lines go against the source axis they run along (bottom to top or right to left)
+     * @return true if the lines are mirrored
+     */
+    bool linesMirrored() const;
+
+    /**
+     * @brief Get the width of the decoded image
+     * @return unsigned int width of the source
+     */
+    unsigned int width() const;
+
+private:
+    unsigned int source_width;
+    bool swap_axes;
+    bool columns_mirrored;
+    bool lines_mirrored;
+    std::vector<size_t> column_offsets;
+    std::vector<size_t> line_offsets;
+    std::vector<Span> column_spans;
+    std::vector<Span> line_spans;
+};
+
+#endif // ASCII_ART_TRANSFORM_HPP
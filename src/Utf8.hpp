@@ -0,0 +1,23 @@
+#ifndef ASCII_ART_UTF8_HPP
+#define ASCII_ART_UTF8_HPP
+
+#include <cstddef>
+
+/**
+ * @brief Walking the UTF-8 text of the images, a cell of the braille and half block modes takes several bytes
+ */
+class Utf8
+{
+public:
+    /**
+     * @brief Get the number of the bytes of the character starting with the byte
+     * @param lead The first byte of the character
+     * @return size_t 1 - 4
+     */
+    static size_t length(unsigned char lead)
+    {
+        return lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+    }
+};
+
+#endif // ASCII_ART_UTF8_HPP